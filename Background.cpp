@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+
+#include "Background.h"
+
+// starfield tiles repeat, so they only need to be big enough not to look tiled
+static const unsigned TileSize = 512;
+
+Background::Background()
+{
+}
+
+bool Background::load(const std::string& path, unsigned width, unsigned height)
+{
+	m_path = path;
+	m_size = sf::Vector2u(width, height);
+	bakeImage();
+	return m_hasImage;
+}
+
+void Background::resize(unsigned width, unsigned height)
+{
+	if (width == m_size.x && height == m_size.y)
+	{
+		return;
+	}
+
+	m_size = sf::Vector2u(width, height);
+	bakeImage();
+
+	for (auto& layer : m_layers)
+	{
+		layer->sprite.setTextureRect(sf::IntRect(0, 0, width, height));
+	}
+}
+
+void Background::bakeImage()
+{
+	m_hasImage = false;
+	if (m_path.empty() || m_size.x == 0 || m_size.y == 0)
+	{
+		return;
+	}
+
+	// the full size image is only needed while baking, so it is loaded here and
+	// dropped again straight after instead of staying in video memory
+	sf::Texture source;
+	if (!source.loadFromFile(m_path))
+	{
+		std::cout << "Error!! Failed to load background texture.\n";
+		return;
+	}
+	source.setSmooth(true);
+	source.generateMipmap();
+
+	if (!m_scaled.create(m_size.x, m_size.y))
+	{
+		std::cout << "Error!! Failed to create background render texture.\n";
+		return;
+	}
+
+	sf::Sprite sprite(source);
+	sprite.setScale(static_cast<float>(m_size.x) / source.getSize().x, static_cast<float>(m_size.y) / source.getSize().y);
+
+	m_scaled.clear();
+	m_scaled.draw(sprite);
+	m_scaled.display();
+
+	m_sprite.setTexture(m_scaled.getTexture(), true);
+	m_sprite.setPosition(0, 0);
+	m_hasImage = true;
+}
+
+void Background::setStarfield(int count, unsigned seed)
+{
+	m_layers.clear();
+
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> pos(0.0f, static_cast<float>(TileSize));
+	std::uniform_int_distribution<int> shade(-30, 30);
+
+	for (int i = 0; i < count; ++i)
+	{
+		auto layer = std::make_unique<Layer>();
+
+		// near layers have fewer, bigger, brighter stars and move faster
+		float depth = count > 1 ? static_cast<float>(i) / (count - 1) : 1.0f;
+		int stars = static_cast<int>(220 - 140 * depth);
+		float size = 1.0f + 1.5f * depth;
+		int brightness = static_cast<int>(120 + 135 * depth);
+		layer->parallax = 0.05f + 0.25f * depth;
+		layer->drift = 0.1f + 0.4f * depth;
+
+		if (!layer->tile.create(TileSize, TileSize))
+		{
+			std::cout << "Error!! Failed to create starfield render texture.\n";
+			return;
+		}
+
+		sf::VertexArray quads(sf::Quads);
+		for (int s = 0; s < stars; ++s)
+		{
+			float x = pos(rng);
+			float y = pos(rng);
+			int b = std::clamp(brightness + shade(rng), 0, 255);
+			sf::Color c(static_cast<sf::Uint8>(b), static_cast<sf::Uint8>(b), static_cast<sf::Uint8>(std::min(b + 20, 255)));
+
+			quads.append(sf::Vertex(sf::Vector2f(x, y), c));
+			quads.append(sf::Vertex(sf::Vector2f(x + size, y), c));
+			quads.append(sf::Vertex(sf::Vector2f(x + size, y + size), c));
+			quads.append(sf::Vertex(sf::Vector2f(x, y + size), c));
+		}
+
+		layer->tile.clear(sf::Color::Transparent);
+		layer->tile.draw(quads);
+		layer->tile.display();
+		layer->tile.setRepeated(true);
+
+		// one sprite covering the window, scrolling moves its texture rect over the repeating tile
+		layer->sprite.setTexture(layer->tile.getTexture());
+		layer->sprite.setTextureRect(sf::IntRect(0, 0, m_size.x, m_size.y));
+
+		m_layers.push_back(std::move(layer));
+	}
+}
+
+void Background::scroll(const sf::Vector2f& camera, int frame)
+{
+	for (auto& layer : m_layers)
+	{
+		// the tile repeats, so wrap the offset to keep it small and exact
+		int x = static_cast<int>(std::fmod(camera.x * layer->parallax + frame * layer->drift, static_cast<float>(TileSize)));
+		int y = static_cast<int>(std::fmod(camera.y * layer->parallax, static_cast<float>(TileSize)));
+		layer->sprite.setTextureRect(sf::IntRect(x, y, m_size.x, m_size.y));
+	}
+}
+
+void Background::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	if (m_hasImage)
+	{
+		target.draw(m_sprite, states);
+	}
+
+	for (auto& layer : m_layers)
+	{
+		target.draw(layer->sprite, states);
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The backdrop behind the game.
+// The background image is resampled once into a texture the size of the window,
+// so each frame draws it 1:1 instead of filtering the full resolution image down
+// again. Optional starfield layers are baked once into small tiles that repeat,
+// each drawn as one textured quad scrolled at its own parallax speed.
+class Background : public sf::Drawable
+{
+	struct Layer
+	{
+		sf::RenderTexture tile;
+		float parallax = 0; // how far the layer moves per pixel of camera movement
+		float drift = 0; // pixels per frame the layer scrolls on its own
+		sf::Sprite sprite;
+	};
+
+	std::string m_path;
+	sf::RenderTexture m_scaled; // the image at window size
+	sf::Sprite m_sprite;
+	bool m_hasImage = false;
+
+	std::vector<std::unique_ptr<Layer>> m_layers;
+	sf::Vector2u m_size;
+
+	void bakeImage();
+
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+public:
+	Background();
+
+	// remember the image and bake it at the given size, false if it can't be loaded
+	bool load(const std::string& path, unsigned width, unsigned height);
+
+	// bake everything again for a new window size
+	void resize(unsigned width, unsigned height);
+
+	// build count starfield layers, far ones first, the same seed gives the same stars
+	void setStarfield(int count, unsigned seed);
+
+	// move the starfield layers for the camera position and the frame number
+	void scroll(const sf::Vector2f& camera, int frame);
+};
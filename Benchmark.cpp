@@ -0,0 +1,235 @@
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <new>
+#include <sstream>
+
+#include "Benchmark.h"
+
+// counting allocations means replacing the global operator new for the whole program,
+// the cost is two relaxed adds per allocation so it stays on outside benchmarks too
+static std::atomic<uint64_t> s_allocations = 0;
+static std::atomic<uint64_t> s_allocatedBytes = 0;
+
+void* operator new(size_t size)
+{
+	s_allocations.fetch_add(1, std::memory_order_relaxed);
+	s_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+
+	void* p = std::malloc(size ? size : 1);
+	if (!p)
+	{
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+uint64_t Allocations::count()
+{
+	return s_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t Allocations::bytes()
+{
+	return s_allocatedBytes.load(std::memory_order_relaxed);
+}
+
+bool Scenario::load(const std::string& file)
+{
+	std::ifstream fin(file);
+	if (!fin.is_open())
+	{
+		return false;
+	}
+
+	path = file;
+	name = file;
+
+	std::string word;
+	while (fin >> word)
+	{
+		if (word == "Name")
+		{
+			fin >> name;
+		}
+		else if (word == "Ticks")
+		{
+			fin >> ticks;
+		}
+		else if (word == "Seed")
+		{
+			fin >> seed;
+		}
+		else if (word == "Enemies")
+		{
+			fin >> enemies;
+		}
+		else if (word == "Fire")
+		{
+			fin >> fire >> fireEvery;
+		}
+		else if (word == "Special")
+		{
+			fin >> specialEvery;
+		}
+	}
+
+	return ticks > 0;
+}
+
+bool BenchmarkReport::save(const std::string& file) const
+{
+	std::ofstream fout(file);
+	if (!fout.is_open())
+	{
+		return false;
+	}
+
+	fout << std::fixed << std::setprecision(6);
+	fout << "{\n";
+	fout << "  \"scenario\": \"" << scenario << "\",\n";
+	fout << "  \"ticks\": " << ticks << ",\n";
+	fout << "  \"seconds\": " << seconds << ",\n";
+	fout << "  \"ticksPerSecond\": " << ticksPerSecond << ",\n";
+	fout << "  \"p50\": " << p50 << ",\n";
+	fout << "  \"p99\": " << p99 << ",\n";
+	fout << "  \"max\": " << max << ",\n";
+	fout << "  \"peakEntities\": " << peakEntities << ",\n";
+	fout << "  \"allocations\": " << allocations << ",\n";
+	fout << "  \"allocatedBytes\": " << allocatedBytes << "\n";
+	fout << "}\n";
+
+	return fout.good();
+}
+
+// value after "key": in text, good enough for the flat objects save() writes
+static bool readValue(const std::string& text, const std::string& key, std::string& value)
+{
+	size_t at = text.find("\"" + key + "\"");
+	if (at == std::string::npos)
+	{
+		return false;
+	}
+
+	at = text.find(':', at);
+	if (at == std::string::npos)
+	{
+		return false;
+	}
+
+	size_t start = text.find_first_not_of(" \t\r\n", at + 1);
+	if (start == std::string::npos)
+	{
+		return false;
+	}
+
+	if (text[start] == '"')
+	{
+		size_t end = text.find('"', start + 1);
+		value = text.substr(start + 1, end - start - 1);
+	}
+	else
+	{
+		size_t end = text.find_first_of(",}\r\n", start);
+		value = text.substr(start, end - start);
+	}
+	return true;
+}
+
+bool BenchmarkReport::load(const std::string& file)
+{
+	std::ifstream fin(file);
+	if (!fin.is_open())
+	{
+		return false;
+	}
+
+	std::stringstream buffer;
+	buffer << fin.rdbuf();
+	std::string text = buffer.str();
+
+	std::string value;
+	bool ok = true;
+	auto number = [&](const char* key) -> double
+	{
+		if (!readValue(text, key, value))
+		{
+			ok = false;
+			return 0;
+		}
+		return std::strtod(value.c_str(), nullptr);
+	};
+
+	if (readValue(text, "scenario", value))
+	{
+		scenario = value;
+	}
+	ticks = static_cast<int>(number("ticks"));
+	seconds = number("seconds");
+	ticksPerSecond = number("ticksPerSecond");
+	p50 = number("p50");
+	p99 = number("p99");
+	max = number("max");
+	peakEntities = static_cast<size_t>(number("peakEntities"));
+	allocations = static_cast<uint64_t>(number("allocations"));
+	allocatedBytes = static_cast<uint64_t>(number("allocatedBytes"));
+
+	return ok;
+}
+
+void BenchmarkReport::print(std::ostream& out) const
+{
+	out << std::fixed << std::setprecision(1);
+	out << scenario << ": " << ticks << " ticks in " << seconds << "s, " << ticksPerSecond << " ticks/s\n";
+	out << "  tick p50 " << p50 << "us, p99 " << p99 << "us, max " << max << "us\n";
+	out << "  peak entities " << peakEntities << ", " << allocations << " allocations (" << allocatedBytes << " bytes)\n";
+}
+
+bool compareReports(const BenchmarkReport& baseline, const BenchmarkReport& current, double thresholdPercent, std::ostream& out)
+{
+	bool passed = true;
+
+	// change in percent, positive is worse
+	auto check = [&](const char* name, double base, double now, bool higherIsBetter, bool checked)
+	{
+		double change = base != 0 ? (now - base) * 100.0 / base : 0;
+		double worse = higherIsBetter ? -change : change;
+		bool failed = checked && worse > thresholdPercent;
+
+		out << std::fixed << std::setprecision(1) << "  " << std::left << std::setw(16) << name << std::right
+			<< std::setw(12) << base << " -> " << std::setw(12) << now
+			<< "  (" << std::showpos << change << std::noshowpos << "%)" << (failed ? "  REGRESSION" : "") << "\n";
+
+		if (failed)
+		{
+			passed = false;
+		}
+	};
+
+	out << "Compared with baseline (threshold " << thresholdPercent << "%)\n";
+	check("ticks/s", baseline.ticksPerSecond, current.ticksPerSecond, true, true);
+	check("p50 us", baseline.p50, current.p50, false, true);
+	check("p99 us", baseline.p99, current.p99, false, true);
+	check("max us", baseline.max, current.max, false, false);
+	check("allocations", static_cast<double>(baseline.allocations), static_cast<double>(current.allocations), false, true);
+
+	// a different workload makes the timings meaningless rather than worse
+	if (baseline.scenario != current.scenario || baseline.ticks != current.ticks || baseline.peakEntities != current.peakEntities)
+	{
+		out << "  warning: baseline ran a different workload (" << baseline.scenario << ", " << baseline.ticks
+			<< " ticks, " << baseline.peakEntities << " peak entities)\n";
+	}
+
+	return passed;
+}
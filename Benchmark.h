@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// A benchmark scenario, read from a file in the same "Keyword values..." format as config.txt.
+// Any config.txt line (Enemy, Bullet, Chase, Bots ...) in the file overrides the config for the run.
+//
+// Name <name>
+// Ticks <frames to simulate>
+// Seed <seed for the game's random numbers>
+// Enemies <enemies spawned up front, on top of the regular spawner>
+// Fire <none|aim|spiral|burst> <every N ticks>
+// Special <special weapon every N ticks, 0 = never>
+struct Scenario
+{
+	std::string name;
+	std::string path;
+	int ticks = 3600;
+	unsigned seed = 1;
+	int enemies = 0;
+	std::string fire = "none";
+	int fireEvery = 10;
+	int specialEvery = 0;
+
+	bool load(const std::string& file);
+};
+
+// What one headless run measured, tick times are in microseconds
+struct BenchmarkReport
+{
+	std::string scenario;
+	int ticks = 0;
+	double seconds = 0;
+	double ticksPerSecond = 0;
+	double p50 = 0;
+	double p99 = 0;
+	double max = 0;
+	size_t peakEntities = 0;
+	uint64_t allocations = 0;
+	uint64_t allocatedBytes = 0;
+
+	bool save(const std::string& file) const;
+	bool load(const std::string& file); // only reads files written by save()
+	void print(std::ostream& out) const;
+};
+
+// Prints each metric against the baseline, returns false if any got worse by more than
+// thresholdPercent. Max tick time is printed but not checked, one hiccup would fail the run.
+bool compareReports(const BenchmarkReport& baseline, const BenchmarkReport& current, double thresholdPercent, std::ostream& out);
+
+// Every operator new in the program is counted, these read the running totals
+namespace Allocations
+{
+	uint64_t count();
+	uint64_t bytes();
+}
@@ -0,0 +1,132 @@
+#include <cmath>
+#include <numbers>
+
+#include "BotController.h"
+#include "Entity.h"
+
+// turn a heading into the four direction keys a player has
+static void steer(const Vec2& heading, BotAction& action)
+{
+	const float deadZone = 0.3f;
+	action.left = heading.x < -deadZone;
+	action.right = heading.x > deadZone;
+	action.up = heading.y < -deadZone;
+	action.down = heading.y > deadZone;
+}
+
+static Vec2 randomHeading(std::minstd_rand& rng)
+{
+	std::uniform_real_distribution<float> angle(0.0f, 2.0f * std::numbers::pi_v<float>);
+	float a = angle(rng);
+	return Vec2(std::cos(a), std::sin(a));
+}
+
+// aim at the enemy, with a little spread so bots don't all shoot the exact same line
+static void aim(const BotView& view, std::minstd_rand& rng, BotAction& action)
+{
+	std::uniform_real_distribution<float> spread(-15.0f, 15.0f);
+	Vec2 enemy = view.nearestEnemy->cTransform->pos;
+	action.target = Vec2(enemy.x + spread(rng), enemy.y + spread(rng));
+}
+
+void WanderStrategy::think(const BotView& view, std::minstd_rand& rng, Vec2& heading, BotAction& action) const
+{
+	std::uniform_int_distribution<int> chance(0, 99);
+
+	if ((heading.x == 0 && heading.y == 0) || chance(rng) < 1)
+	{
+		heading = randomHeading(rng);
+	}
+
+	// turn back toward the middle near the walls
+	const float margin = 80.0f;
+	if (view.pos.x < margin || view.pos.x > view.worldSize.x - margin || view.pos.y < margin || view.pos.y > view.worldSize.y - margin)
+	{
+		Vec2 toCenter = view.worldSize * 0.5f - view.pos;
+		float len = toCenter.dist(Vec2(0, 0));
+		if (len > 0)
+		{
+			heading = toCenter / len;
+		}
+	}
+
+	steer(heading, action);
+
+	if (view.nearestEnemy && view.frame % 10 == 0)
+	{
+		action.fire = true;
+		aim(view, rng, action);
+	}
+}
+
+void KiteStrategy::think(const BotView& view, std::minstd_rand& rng, Vec2& heading, BotAction& action) const
+{
+	if (!view.nearestEnemy)
+	{
+		WanderStrategy().think(view, rng, heading, action);
+		return;
+	}
+
+	Vec2 toEnemy = view.nearestEnemy->cTransform->pos - view.pos;
+	float dist = toEnemy.dist(Vec2(0, 0));
+	Vec2 dir = dist > 0 ? toEnemy / dist : Vec2(1, 0);
+
+	const float tooClose = 200.0f;
+	const float tooFar = 350.0f;
+	if (dist < tooClose)
+	{
+		heading = dir * -1.0f;
+	}
+	else if (dist > tooFar)
+	{
+		heading = dir;
+	}
+	else
+	{
+		// circle around it
+		heading = Vec2(-dir.y, dir.x);
+	}
+
+	steer(heading, action);
+
+	if (view.frame % 6 == 0)
+	{
+		action.fire = true;
+		aim(view, rng, action);
+	}
+	action.special = view.frame % 300 == 0;
+}
+
+void TurretStrategy::think(const BotView& view, std::minstd_rand& rng, Vec2& heading, BotAction& action) const
+{
+	heading = Vec2(0, 0);
+	steer(heading, action);
+
+	if (view.nearestEnemy && view.frame % 4 == 0)
+	{
+		action.fire = true;
+		aim(view, rng, action);
+	}
+	action.special = view.frame % 120 == 0;
+}
+
+std::shared_ptr<BotStrategy> makeBotStrategy(const std::string& name, int index)
+{
+	static const auto wander = std::make_shared<WanderStrategy>();
+	static const auto kite = std::make_shared<KiteStrategy>();
+	static const auto turret = std::make_shared<TurretStrategy>();
+
+	if (name == "wander") return wander;
+	if (name == "kite") return kite;
+	if (name == "turret") return turret;
+	if (name == "mixed")
+	{
+		switch (index % 3)
+		{
+		case 0: return wander;
+		case 1: return kite;
+		default: return turret;
+		}
+	}
+	return nullptr;
+}
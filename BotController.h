@@ -0,0 +1,67 @@
+#pragma once
+
+#include <memory>
+#include <random>
+#include <string>
+
+#include "Vec2.h"
+
+class Entity;
+
+// What a bot can see when it decides what to do
+struct BotView
+{
+	Vec2 pos; // the bot's own position
+	const Entity* nearestEnemy = nullptr; // closest enemy or small enemy, if there is one
+	Vec2 worldSize;
+	int frame = 0;
+};
+
+// What a bot decided to do this frame, the game turns it into CInput and spawns
+struct BotAction
+{
+	bool up = false;
+	bool down = false;
+	bool left = false;
+	bool right = false;
+	bool fire = false; // spawnBullet toward target
+	bool special = false; // spawnSpecialWeapon
+	Vec2 target;
+};
+
+// A way of playing. One strategy object is shared by every bot using it, anything
+// a bot needs to remember between frames lives in its CBot component.
+class BotStrategy
+{
+public:
+	virtual ~BotStrategy() {}
+	virtual const char* name() const = 0;
+	virtual void think(const BotView& view, std::minstd_rand& rng, Vec2& heading, BotAction& action) const = 0;
+};
+
+// drifts around picking a new direction every second or two, shoots now and then
+class WanderStrategy : public BotStrategy
+{
+public:
+	const char* name() const override { return "wander"; }
+	void think(const BotView& view, std::minstd_rand& rng, Vec2& heading, BotAction& action) const override;
+};
+
+// keeps the nearest enemy at a distance, circling it and shooting a lot
+class KiteStrategy : public BotStrategy
+{
+public:
+	const char* name() const override { return "kite"; }
+	void think(const BotView& view, std::minstd_rand& rng, Vec2& heading, BotAction& action) const override;
+};
+
+// stands still and fires as fast as it can, special weapon included
+class TurretStrategy : public BotStrategy
+{
+public:
+	const char* name() const override { return "turret"; }
+	void think(const BotView& view, std::minstd_rand& rng, Vec2& heading, BotAction& action) const override;
+};
+
+// strategy by name, "mixed" cycles through all of them using index, nullptr if unknown
+std::shared_ptr<BotStrategy> makeBotStrategy(const std::string& name, int index);
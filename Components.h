@@ -1,7 +1,10 @@
 #pragma once
 
 #include "Vec2.h"
+#include "BotController.h"
 #include <SFML/Graphics.hpp>
+#include <memory>
+#include <random>
 
 class CTransform
 {
@@ -19,9 +22,12 @@ class CShape
 {
 public:
 	sf::CircleShape circle;
+	size_t points = 0; // point count the shape was made with, the circle may be drawn with fewer
+	float outline = 0; // outline thickness the shape was made with
+	int lod = 0; // quality level the circle was last set up for, times 2, plus 1 if it was far from the camera
 
 	CShape(float radius, int points, const sf::Color& fill, const sf::Color& outline, float thickness)
-		:circle(radius, points)
+		:circle(radius, points), points(points), outline(thickness)
 	{
 		circle.setFillColor(fill);
 		circle.setOutlineColor(outline);
@@ -55,6 +61,16 @@ public:
 		: remaining(total), total(total) {}
 };
 
+// Component for projectiles that steer toward the nearest enemy
+class CHoming
+{
+public:
+	float turnRate = 0; // fraction of the way the velocity turns toward the target each frame
+	float range = 0; // only enemies closer than this are chased
+	CHoming(float turn, float r)
+		: turnRate(turn), range(r) {}
+};
+
 //Component to store if user pressing any key stated
 class CInput
 {
@@ -68,6 +84,19 @@ public:
 	CInput() {}
 };
 
+// Component for players driven by a bot instead of the keyboard
+class CBot
+{
+public:
+	std::shared_ptr<BotStrategy> strategy;
+	std::minstd_rand rng; // each bot has its own so runs with the same seed play out the same
+	Vec2 heading = { 0.0, 0.0 }; // where the bot wants to go, kept between frames
+	int index = 0; // which bot this is, also spreads the bots' actions over different frames
+
+	CBot(std::shared_ptr<BotStrategy> s, unsigned seed, int i)
+		: strategy(s), rng(seed), index(i) {}
+};
+
 class CGraphics {
 public:
 	// Constructor to initialize the graphics component with an SFML drawable object
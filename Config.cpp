@@ -0,0 +1,371 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <type_traits>
+
+#include "Config.h"
+#include "BotController.h"
+
+static void checkColor(int r, int g, int b, const std::string& what, std::vector<std::string>& problems)
+{
+	if (r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255)
+	{
+		problems.push_back(what + " colour values must be 0 to 255");
+	}
+}
+
+// range and consistency checks over a whole parsed config
+static void validate(const GameConfig& c, std::vector<std::string>& problems)
+{
+	if (c.window.W == 0 || c.window.H == 0 || c.window.FS > 1)
+	{
+		problems.push_back("Window needs a size and fullscreen 0 or 1");
+	}
+
+	if (c.font.F.empty() || c.font.S <= 0)
+	{
+		problems.push_back("Font needs a file and a size");
+	}
+	checkColor(c.font.R, c.font.G, c.font.B, "Font", problems);
+
+	const PlayerConfig& p = c.player;
+	if (p.SR <= 0 || p.CR <= 0 || p.S <= 0 || p.OT < 0 || p.V < 3)
+	{
+		problems.push_back("Player radii and speed must be positive, at least 3 vertices");
+	}
+	checkColor(p.FR, p.FG, p.FB, "Player fill", problems);
+	checkColor(p.OR, p.OG, p.OB, "Player outline", problems);
+
+	const EnemyConfig& e = c.enemy;
+	if (e.SR <= 0 || e.CR <= 0 || e.OT < 0 || e.L <= 0 || e.SI <= 0)
+	{
+		problems.push_back("Enemy radii, lifespan and spawn interval must be positive");
+	}
+	if (e.SMIN <= 0 || e.SMIN > e.SMAX)
+	{
+		problems.push_back("Enemy speed needs 0 < SMIN <= SMAX");
+	}
+	if (e.VMIN < 3 || e.VMIN > e.VMAX)
+	{
+		problems.push_back("Enemy vertices need 3 <= VMIN <= VMAX");
+	}
+	checkColor(e.OR, e.OG, e.OB, "Enemy outline", problems);
+
+	const BulletConfig& b = c.bullet;
+	if (b.SR <= 0 || b.CR <= 0 || b.S <= 0 || b.OT < 0 || b.V < 3 || b.L <= 0)
+	{
+		problems.push_back("Bullet radii, speed and lifespan must be positive, at least 3 vertices");
+	}
+	if (b.HT <= 0 || b.HT > 1 || b.HR < 0)
+	{
+		problems.push_back("Bullet homing turn rate must be in (0, 1], its range can't be negative");
+	}
+	checkColor(b.FR, b.FG, b.FB, "Bullet fill", problems);
+	checkColor(b.OR, b.OG, b.OB, "Bullet outline", problems);
+
+	if (c.chase.CS <= 0)
+	{
+		problems.push_back("Chase cell size must be positive");
+	}
+
+	if (c.world.W < 0 || c.world.H < 0 || c.world.FD < 0 || c.world.FT < 1)
+	{
+		problems.push_back("World sizes and distance can't be negative, FT at least 1");
+	}
+
+	if (c.bots.N < 0 || !makeBotStrategy(c.bots.S, 0))
+	{
+		problems.push_back("Bots needs a count of 0 or more and a known strategy");
+	}
+
+	if (c.rollback.N < 2 || c.rollback.D < 0 || c.rollback.D >= c.rollback.N)
+	{
+		problems.push_back("Rollback needs at least 2 ticks kept and an input delay shorter than that");
+	}
+
+	if (c.regions.C < 0 || c.regions.R < 1)
+	{
+		problems.push_back("Regions needs 0 or more columns and at least 1 row");
+	}
+
+	if (c.starfield < 0 || c.metrics < 0 || c.metrics > 65535)
+	{
+		problems.push_back("Starfield can't be negative, Metrics must be a port number or 0");
+	}
+}
+
+bool loadConfig(const std::string& path, GameConfig& config, std::vector<std::string>& errors, bool allowUnknown)
+{
+	std::ifstream fin(path);
+	if (!fin.is_open())
+	{
+		errors.push_back(path + ": can't open the file");
+		return false;
+	}
+
+	size_t errorsBefore = errors.size();
+	std::string line;
+	int lineNumber = 0;
+
+	while (std::getline(fin, line))
+	{
+		++lineNumber;
+		std::istringstream in(line);
+		std::string word;
+		if (!(in >> word))
+		{
+			continue;
+		}
+
+		// read into a copy, a line that fails part way through changes nothing
+		GameConfig next = config;
+		if (word == "Window")
+		{
+			in >> next.window.W >> next.window.H >> next.window.FL >> next.window.FS;
+		}
+		else if (word == "Font")
+		{
+			in >> next.font.F >> next.font.S >> next.font.R >> next.font.G >> next.font.B;
+		}
+		else if (word == "Player")
+		{
+			PlayerConfig& p = next.player;
+			in >> p.SR >> p.CR >> p.S >> p.FR >> p.FG >> p.FB >> p.OR >> p.OG >> p.OB >> p.OT >> p.V;
+		}
+		else if (word == "Enemy")
+		{
+			EnemyConfig& e = next.enemy;
+			in >> e.SR >> e.CR >> e.SMIN >> e.SMAX >> e.OR >> e.OG >> e.OB >> e.OT >> e.VMIN >> e.VMAX >> e.L >> e.SI;
+		}
+		else if (word == "Bullet")
+		{
+			BulletConfig& b = next.bullet;
+			in >> b.SR >> b.CR >> b.S >> b.FR >> b.FG >> b.FB >> b.OR >> b.OG >> b.OB >> b.OT >> b.V >> b.L;
+
+			// the homing values came later, a line without them keeps the defaults
+			if (!in.eof() && !(in >> std::ws).eof())
+			{
+				in >> b.HT >> b.HR;
+			}
+		}
+		else if (word == "Waves")
+		{
+			in >> next.waves;
+		}
+		else if (word == "Chase")
+		{
+			in >> next.chase.ON >> next.chase.MT >> next.chase.CS;
+		}
+		else if (word == "Scheduler")
+		{
+			in >> next.scheduler;
+		}
+		else if (word == "Governor")
+		{
+			in >> next.governor;
+		}
+		else if (word == "Starfield")
+		{
+			in >> next.starfield;
+		}
+		else if (word == "Metrics")
+		{
+			in >> next.metrics;
+		}
+		else if (word == "Bots")
+		{
+			in >> next.bots.N >> next.bots.S >> next.bots.SD;
+		}
+		else if (word == "World")
+		{
+			in >> next.world.W >> next.world.H >> next.world.FD >> next.world.FT;
+		}
+		else if (word == "Rollback")
+		{
+			in >> next.rollback.ON >> next.rollback.N >> next.rollback.D;
+		}
+		else if (word == "Regions")
+		{
+			in >> next.regions.ON >> next.regions.C >> next.regions.R;
+		}
+		else if (word == "Reload")
+		{
+			in >> next.reload;
+		}
+		else
+		{
+			if (!allowUnknown)
+			{
+				errors.push_back(path + ":" + std::to_string(lineNumber) + ": unknown setting " + word);
+			}
+			continue;
+		}
+
+		std::string extra;
+		if (in.fail())
+		{
+			errors.push_back(path + ":" + std::to_string(lineNumber) + ": " + word + " has missing or non-numeric values");
+		}
+		else if (in >> extra)
+		{
+			errors.push_back(path + ":" + std::to_string(lineNumber) + ": unexpected " + extra + " after the " + word + " values");
+		}
+		else
+		{
+			config = next;
+		}
+	}
+
+	std::vector<std::string> problems;
+	validate(config, problems);
+	for (auto& p : problems)
+	{
+		errors.push_back(path + ": " + p);
+	}
+
+	return errors.size() == errorsBefore;
+}
+
+// binary layout: header, the plain structs as they are in memory, then the strings
+static const uint32_t CompiledMagic = 0x43574743; // "CGWC"
+static const uint32_t CompiledVersion = 4;
+
+struct CompiledHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t layout; // sum of the struct sizes, catches a build with different structs
+	uint32_t padding;
+	int64_t sourceTime;
+	uint64_t sourceSize;
+};
+
+static uint32_t compiledLayout()
+{
+	return static_cast<uint32_t>(sizeof(WindowConfig) + sizeof(PlayerConfig) + sizeof(EnemyConfig) + sizeof(BulletConfig)
+		+ sizeof(ChaseConfig) + sizeof(WorldConfig) + sizeof(RollbackConfig) + sizeof(RegionsConfig) + 8 * sizeof(int));
+}
+
+static bool sourceStamp(const std::string& source, int64_t& time, uint64_t& size)
+{
+	std::error_code ec;
+	auto t = std::filesystem::last_write_time(source, ec);
+	if (ec)
+	{
+		return false;
+	}
+	size = std::filesystem::file_size(source, ec);
+	time = static_cast<int64_t>(t.time_since_epoch().count());
+	return !ec;
+}
+
+template<typename T>
+static void put(std::ofstream& out, const T& value)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+static bool get(std::ifstream& in, T& value)
+{
+	static_assert(std::is_trivially_copyable_v<T>);
+	return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+static void putString(std::ofstream& out, const std::string& s)
+{
+	put(out, static_cast<uint32_t>(s.size()));
+	out.write(s.data(), s.size());
+}
+
+static bool getString(std::ifstream& in, std::string& s)
+{
+	uint32_t size = 0;
+	if (!get(in, size) || size > 4096)
+	{
+		return false;
+	}
+	s.resize(size);
+	return static_cast<bool>(in.read(s.data(), size));
+}
+
+bool saveCompiledConfig(const std::string& path, const GameConfig& config, const std::string& source)
+{
+	CompiledHeader header = { CompiledMagic, CompiledVersion, compiledLayout(), 0, 0, 0 };
+	if (!sourceStamp(source, header.sourceTime, header.sourceSize))
+	{
+		return false;
+	}
+
+	std::ofstream out(path, std::ios::binary);
+	if (!out.is_open())
+	{
+		return false;
+	}
+
+	put(out, header);
+	put(out, config.window);
+	put(out, config.player);
+	put(out, config.enemy);
+	put(out, config.bullet);
+	put(out, config.chase);
+	put(out, config.world);
+	put(out, config.rollback);
+	put(out, config.regions);
+	int numbers[8] = { config.font.S, config.font.R, config.font.G, config.font.B, config.bots.N, static_cast<int>(config.bots.SD), 0, 0 };
+	int flags[6] = { config.waves, config.scheduler, config.governor, config.starfield, config.metrics, config.reload };
+	put(out, numbers);
+	put(out, flags);
+	putString(out, config.font.F);
+	putString(out, config.bots.S);
+
+	return out.good();
+}
+
+bool loadCompiledConfig(const std::string& path, const std::string& source, GameConfig& config)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in.is_open())
+	{
+		return false;
+	}
+
+	CompiledHeader header;
+	int64_t time = 0;
+	uint64_t size = 0;
+	if (!get(in, header) || header.magic != CompiledMagic || header.version != CompiledVersion
+		|| header.layout != compiledLayout() || !sourceStamp(source, time, size)
+		|| header.sourceTime != time || header.sourceSize != size)
+	{
+		return false;
+	}
+
+	GameConfig c;
+	int numbers[8];
+	int flags[6];
+	bool ok = get(in, c.window) && get(in, c.player) && get(in, c.enemy) && get(in, c.bullet)
+		&& get(in, c.chase) && get(in, c.world) && get(in, c.rollback) && get(in, c.regions) && get(in, numbers) && get(in, flags)
+		&& getString(in, c.font.F) && getString(in, c.bots.S);
+	if (!ok)
+	{
+		return false;
+	}
+
+	c.font.S = numbers[0];
+	c.font.R = numbers[1];
+	c.font.G = numbers[2];
+	c.font.B = numbers[3];
+	c.bots.N = numbers[4];
+	c.bots.SD = static_cast<unsigned>(numbers[5]);
+	c.waves = flags[0];
+	c.scheduler = flags[1];
+	c.governor = flags[2];
+	c.starfield = flags[3];
+	c.metrics = flags[4];
+	c.reload = flags[5];
+
+	config = c;
+	return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// One struct per config.txt line. The defaults are what the game starts with when config.txt
+// has errors, config.txt is expected to set everything that matters.
+struct WindowConfig { unsigned W = 1280, H = 720, FL = 60, FS = 0; bool operator==(const WindowConfig&) const = default; }; // size, frame limit, fullscreen
+struct FontConfig { std::string F = "tech.ttf"; int S = 20, R = 255, G = 255, B = 255; bool operator==(const FontConfig&) const = default; };
+struct PlayerConfig { int SR = 32, CR = 32, FR = 255, FG = 255, FB = 255, OR = 255, OG = 255, OB = 255, OT = 2, V = 8; float S = 5; bool operator==(const PlayerConfig&) const = default; };
+struct EnemyConfig { int SR = 32, CR = 32, OR = 255, OG = 255, OB = 255, OT = 2, VMIN = 3, VMAX = 8, L = 90, SI = 60; float SMIN = 3, SMAX = 3; bool operator==(const EnemyConfig&) const = default; };
+struct BulletConfig { int SR = 10, CR = 10, FR = 255, FG = 255, FB = 255, OR = 255, OG = 255, OB = 255, OT = 2, V = 20, L = 90; float S = 20, HT = 0.08f, HR = 400; bool operator==(const BulletConfig&) const = default; }; // HT and HR are the special's homing turn rate and range
+struct ChaseConfig { int ON = 0, MT = 0, CS = 40; bool operator==(const ChaseConfig&) const = default; }; // enemies chase the player, build the field on a worker thread, field cell size
+struct WorldConfig { int W = 0, H = 0, FD = 0, FT = 1; bool operator==(const WorldConfig&) const = default; }; // world size (0 = window size), distance from the camera past which entities only move every FT ticks
+struct RollbackConfig { int ON = 0, N = 16, D = 0; bool operator==(const RollbackConfig&) const = default; }; // rollback with a loopback peer, ticks kept, the peer's input delay in ticks
+struct RegionsConfig { int ON = 0, C = 0, R = 1; bool operator==(const RegionsConfig&) const = default; }; // simulate the world split into regions, columns (0 = one per thread), rows
+struct BotsConfig { int N = 0; std::string S = "mixed"; unsigned SD = 1; bool operator==(const BotsConfig&) const = default; }; // count, strategy, seed
+
+// Everything config.txt can set
+struct GameConfig
+{
+	WindowConfig window;
+	FontConfig font;
+	PlayerConfig player;
+	EnemyConfig enemy;
+	BulletConfig bullet;
+	ChaseConfig chase;
+	WorldConfig world;
+	BotsConfig bots;
+	RollbackConfig rollback;
+	RegionsConfig regions;
+	int waves = 0;
+	int scheduler = 0;
+	int governor = 1;
+	int starfield = 0;
+	int metrics = 0;
+	int reload = 1; // watch the file and apply changes while the game runs
+
+	bool operator==(const GameConfig&) const = default;
+};
+
+// Reads a config file over whatever is already in config, so a scenario file can override
+// the main one. A line that doesn't parse is reported and skipped as a whole rather than
+// leaving half a struct set. Problems are added to errors as "file:line: message", with the
+// range checks done over the result at the end. False if the file can't be opened or had
+// any problem. allowUnknown lets other files (scenarios) keep their own keywords.
+bool loadConfig(const std::string& path, GameConfig& config, std::vector<std::string>& errors, bool allowUnknown = false);
+
+// A compiled config is the parsed, validated result written out as binary so startup can
+// skip the text entirely. It remembers the size and time of the text it came from and
+// won't load once the text has changed, or if it was written by a different build.
+bool saveCompiledConfig(const std::string& path, const GameConfig& config, const std::string& source);
+bool loadCompiledConfig(const std::string& path, const std::string& source, GameConfig& config);
@@ -0,0 +1,181 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+#include "ConfigWatcher.h"
+
+// editors often write a file in several steps, wait until it has been quiet this long
+static const std::chrono::milliseconds Settle{ 150 };
+
+// longest the thread blocks before checking m_running again
+static const int WaitMs = 200;
+
+ConfigWatcher::ConfigWatcher()
+{
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+	stop();
+}
+
+void ConfigWatcher::start(const std::string& path)
+{
+	if (m_running)
+	{
+		return;
+	}
+
+	m_path = path;
+
+	std::error_code ec;
+	m_lastWrite = std::filesystem::last_write_time(m_path, ec);
+
+	m_running = true;
+	m_thread = std::thread(&ConfigWatcher::loop, this);
+}
+
+void ConfigWatcher::stop()
+{
+	m_running = false;
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+bool ConfigWatcher::take(GameConfig& config)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!m_hasPending)
+	{
+		return false;
+	}
+
+	config = m_pending;
+	m_hasPending = false;
+	return true;
+}
+
+// the directory notifications fire for any file in it, this is what decides
+bool ConfigWatcher::changed()
+{
+	std::error_code ec;
+	auto time = std::filesystem::last_write_time(m_path, ec);
+	if (ec || time == m_lastWrite)
+	{
+		return false;
+	}
+
+	// keep waiting while the file is still being written
+	do
+	{
+		m_lastWrite = time;
+		std::this_thread::sleep_for(Settle);
+		time = std::filesystem::last_write_time(m_path, ec);
+	} while (!ec && time != m_lastWrite && m_running);
+
+	return !ec;
+}
+
+void ConfigWatcher::reload()
+{
+	GameConfig config;
+	std::vector<std::string> errors;
+	if (!loadConfig(m_path, config, errors))
+	{
+		std::cout << "Config reload rejected, keeping the current settings:\n";
+		for (auto& e : errors)
+		{
+			std::cout << "  " << e << "\n";
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_pending = config;
+	m_hasPending = true;
+}
+
+void ConfigWatcher::loop()
+{
+	std::filesystem::path dir = std::filesystem::absolute(m_path).parent_path();
+
+#ifdef _WIN32
+	HANDLE change = FindFirstChangeNotificationW(dir.c_str(), FALSE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+#elif defined(__linux__)
+	// IN_MOVED_TO and IN_CREATE catch editors that save by renaming a temp file over the old one
+	int notify = inotify_init1(IN_NONBLOCK);
+	if (notify >= 0 && inotify_add_watch(notify, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+	{
+		close(notify);
+		notify = -1;
+	}
+#endif
+
+	while (m_running)
+	{
+#ifdef _WIN32
+		if (change != INVALID_HANDLE_VALUE)
+		{
+			if (WaitForSingleObject(change, WaitMs) != WAIT_OBJECT_0)
+			{
+				continue;
+			}
+			FindNextChangeNotification(change);
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(WaitMs));
+		}
+#elif defined(__linux__)
+		if (notify >= 0)
+		{
+			pollfd p = { notify, POLLIN, 0 };
+			if (poll(&p, 1, WaitMs) <= 0)
+			{
+				continue;
+			}
+
+			// only the wake up matters, changed() looks at the file itself
+			char buffer[4096];
+			while (read(notify, buffer, sizeof(buffer)) > 0)
+			{
+			}
+		}
+		else
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(WaitMs));
+		}
+#else
+		std::this_thread::sleep_for(std::chrono::milliseconds(WaitMs));
+#endif
+
+		if (changed())
+		{
+			reload();
+		}
+	}
+
+#ifdef _WIN32
+	if (change != INVALID_HANDLE_VALUE)
+	{
+		FindCloseChangeNotification(change);
+	}
+#elif defined(__linux__)
+	if (notify >= 0)
+	{
+		close(notify);
+	}
+#endif
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Config.h"
+
+// Watches a config file on its own thread. When the file changes it is reparsed and
+// validated there, off the game thread, and only a config that loaded without any error
+// is handed over; a broken edit just prints its errors and the game keeps what it has.
+// The game picks the new config up with take() between ticks, so a tick never sees
+// half of one config and half of another.
+//
+// Waiting uses the OS change notification on the file's directory where there is one
+// (inotify, FindFirstChangeNotification) and falls back to checking the file time.
+class ConfigWatcher
+{
+	std::string m_path;
+	std::thread m_thread;
+	std::atomic<bool> m_running = false;
+
+	std::mutex m_mutex;
+	GameConfig m_pending;
+	bool m_hasPending = false;
+
+	std::filesystem::file_time_type m_lastWrite;
+
+	void loop();
+	bool changed();
+	void reload();
+
+public:
+	ConfigWatcher();
+	~ConfigWatcher();
+
+	void start(const std::string& path);
+	void stop();
+
+	// game thread, true and fills config if a new valid config arrived since the last call
+	bool take(GameConfig& config);
+};
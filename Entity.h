@@ -24,6 +24,8 @@ public:
 	std::shared_ptr<CInput> cInput;
 	std::shared_ptr<CScore> cScore;
 	std::shared_ptr<CLifespan> cLifespan;
+	std::shared_ptr<CHoming> cHoming;
+	std::shared_ptr<CBot> cBot;
 
 	bool isActive() const;
 	const std::string& tag() const;
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -18,7 +19,9 @@ void EntityManager::update()
 	}
 
 	// remove dead entities from the vector of all entities
+	size_t before = m_entities.size();
 	removeDeadEntities(m_entities);
+	m_totalRemoved += before - m_entities.size();
 
 	// remove dead entities from each vector in the entity map
 	// use C++20 of interating through [key, value] pairs in a map
@@ -43,6 +46,66 @@ std::shared_ptr<Entity> EntityManager::addEntity(const std::string& tag)
 	return entity;
 }
 
+// one entity of a batch and every component it could have, the ones the prefab leaves empty stay empty
+struct BatchParts
+{
+	Entity entity;
+	std::optional<CTransform> transform;
+	std::optional<CShape> shape;
+	std::optional<CCollision> collision;
+	std::optional<CLifespan> lifespan;
+	std::optional<CScore> score;
+	std::optional<CHoming> homing;
+
+	BatchParts(const Entity& e, const Prefab& p)
+		: entity(e), transform(p.transform), shape(p.shape), collision(p.collision)
+		, lifespan(p.lifespan), score(p.score), homing(p.homing) {}
+};
+
+using Batch = std::vector<BatchParts>;
+
+// a pointer to part of the batch that keeps the whole batch alive, no allocation
+template<typename T>
+static std::shared_ptr<T> alias(const std::shared_ptr<Batch>& batch, std::optional<T>& part)
+{
+	return part ? std::shared_ptr<T>(batch, &*part) : nullptr;
+}
+
+size_t EntityManager::addBatch(const Prefab& prefab, size_t count)
+{
+	size_t first = m_entitiesToAdd.size();
+	if (count == 0)
+	{
+		return first;
+	}
+	// grow the way push_back would, exactly first + count every time would copy the list on every batch
+	if (m_entitiesToAdd.capacity() < first + count)
+	{
+		m_entitiesToAdd.reserve(std::max(first + count, m_entitiesToAdd.capacity() * 2));
+	}
+
+	// every part is copied from this one, so the prefab's shape is laid out once instead of per entity
+	BatchParts prototype(Entity(0, prefab.tag), prefab);
+	// the vector and its buffer are two allocations for the whole batch, however big it is
+	auto batch = std::make_shared<Batch>(count, prototype);
+
+	for (BatchParts& parts : *batch)
+	{
+		Entity& e = parts.entity;
+		e.m_id = m_totalEntities++;
+		e.cTransform = alias(batch, parts.transform);
+		e.cShape = alias(batch, parts.shape);
+		e.cCollision = alias(batch, parts.collision);
+		e.cLifespan = alias(batch, parts.lifespan);
+		e.cScore = alias(batch, parts.score);
+		e.cHoming = alias(batch, parts.homing);
+
+		m_entitiesToAdd.push_back(std::shared_ptr<Entity>(batch, &e));
+	}
+
+	return first;
+}
+
 const EntityVec& EntityManager::getEntities()
 {
 	return m_entities;
@@ -50,5 +113,122 @@ const EntityVec& EntityManager::getEntities()
 
 const EntityVec& EntityManager::getEntities(const std::string& tag)
 {
-	return m_entityMap[tag];
+	// look up instead of m_entityMap[tag] so systems running in parallel never insert into the map
+	static const EntityVec noEntities;
+	auto it = m_entityMap.find(tag);
+	return it != m_entityMap.end() ? it->second : noEntities;
+}
+
+size_t EntityManager::totalCreated() const
+{
+	return m_totalEntities;
+}
+
+size_t EntityManager::totalRemoved() const
+{
+	return m_totalRemoved;
+}
+
+static void saveEntity(const std::shared_ptr<Entity>& e, bool pending, EntityState& s)
+{
+	s.entity = e;
+	s.active = e->isActive();
+	s.pending = pending;
+	if (e->cTransform)
+	{
+		s.pos = e->cTransform->pos;
+		s.velocity = e->cTransform->velocity;
+		s.angle = e->cTransform->angle;
+	}
+	if (e->cShape)
+	{
+		s.fill = e->cShape->circle.getFillColor();
+		s.outline = e->cShape->circle.getOutlineColor();
+	}
+	if (e->cLifespan)
+	{
+		s.lifespan = e->cLifespan->remaining;
+	}
+	if (e->cInput)
+	{
+		s.input = *e->cInput;
+	}
+	if (e->cBot)
+	{
+		s.heading = e->cBot->heading;
+		s.rng = e->cBot->rng;
+	}
+}
+
+void EntityManager::save(EntitySnapshot& snapshot) const
+{
+	// resize rather than clear + push_back so a reused snapshot doesn't allocate
+	snapshot.entities.resize(m_entities.size() + m_entitiesToAdd.size());
+
+	size_t i = 0;
+	for (auto& e : m_entities)
+	{
+		saveEntity(e, false, snapshot.entities[i++]);
+	}
+	for (auto& e : m_entitiesToAdd)
+	{
+		saveEntity(e, true, snapshot.entities[i++]);
+	}
+
+	snapshot.totalEntities = m_totalEntities;
+	snapshot.totalRemoved = m_totalRemoved;
+}
+
+void EntityManager::restore(const EntitySnapshot& snapshot)
+{
+	m_entities.clear();
+	m_entitiesToAdd.clear();
+	for (auto& [tag, entityVec] : m_entityMap)
+	{
+		entityVec.clear();
+	}
+
+	for (auto& s : snapshot.entities)
+	{
+		Entity& e = *s.entity;
+		e.m_active = s.active;
+		if (e.cTransform)
+		{
+			e.cTransform->pos = s.pos;
+			e.cTransform->velocity = s.velocity;
+			e.cTransform->angle = s.angle;
+		}
+		if (e.cShape)
+		{
+			e.cShape->circle.setFillColor(s.fill);
+			e.cShape->circle.setOutlineColor(s.outline);
+		}
+		if (e.cLifespan)
+		{
+			e.cLifespan->remaining = s.lifespan;
+		}
+		if (e.cInput)
+		{
+			*e.cInput = s.input;
+		}
+		if (e.cBot)
+		{
+			e.cBot->heading = s.heading;
+			e.cBot->rng = s.rng;
+		}
+
+		// the map vectors are the entity list filtered by tag, in the same order
+		if (s.pending)
+		{
+			m_entitiesToAdd.push_back(s.entity);
+		}
+		else
+		{
+			m_entities.push_back(s.entity);
+			m_entityMap[e.tag()].push_back(s.entity);
+		}
+	}
+
+	m_totalEntities = snapshot.totalEntities;
+	m_totalRemoved = snapshot.totalRemoved;
 }
@@ -4,26 +4,80 @@
 #include <map>
 
 #include "Entity.h"
+#include "Prefab.h"
 
 typedef std::vector<std::shared_ptr<Entity>> EntityVec;
 typedef std::map<std::string, EntityVec> EntityMap;
 
+// What a snapshot keeps of one entity. Components are only ever set when an entity is
+// spawned, so holding on to the entity keeps them too and only the values that change
+// afterwards are copied
+struct EntityState
+{
+	std::shared_ptr<Entity> entity; // keeps it alive after it dies, so a restore can bring it back
+	bool active = true;
+	bool pending = false; // made this tick, not in the entity list yet
+	Vec2 pos;
+	Vec2 velocity;
+	float angle = 0;
+	sf::Color fill; // the lifespan fade
+	sf::Color outline;
+	int lifespan = 0;
+	CInput input;
+	Vec2 heading; // bot
+	std::minstd_rand rng;
+};
+
+struct EntitySnapshot
+{
+	std::vector<EntityState> entities; // list order, then the pending ones
+	size_t totalEntities = 0;
+	size_t totalRemoved = 0;
+};
+
 class EntityManager
 {
 	EntityVec m_entities;
 	EntityVec m_entitiesToAdd;
 	EntityMap m_entityMap;
 	size_t m_totalEntities = 0;
+	size_t m_totalRemoved = 0;
 
 	void removeDeadEntities(EntityVec& vec);
 
+	// queues count entities made from prefab, returns where the first one is in m_entitiesToAdd
+	size_t addBatch(const Prefab& prefab, size_t count);
+
 public:
 	EntityManager();
 	void update();
 
 	std::shared_ptr<Entity> addEntity(const std::string& tag);
 
+	// Like addEntity count times, but the entities and their components (copied from the
+	// prefab) all live in one block made with a single allocation, and the pending list
+	// grows at most once. init(entity, i) is called for each in order to set what differs.
+	// The block is freed once the last entity or component pointer into it goes.
+	template<typename Init>
+	void spawnBatch(const Prefab& prefab, size_t count, Init&& init)
+	{
+		size_t first = addBatch(prefab, count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			init(*m_entitiesToAdd[first + i], i);
+		}
+	}
+
 	const EntityVec& getEntities();
 	const EntityVec& getEntities(const std::string& tag); 
 
+	size_t totalCreated() const; // ids handed out so far, including entities not added yet
+	size_t totalRemoved() const; // dead entities removed by update() so far
+
+	// for rollback: copy out everything update() and the systems change, and put it back.
+	// Entities made after the save are dropped by restore, ids are handed out again from
+	// the saved count so a resimulation gives them the same ones
+	void save(EntitySnapshot& snapshot) const;
+	void restore(const EntitySnapshot& snapshot);
+
 };
\ No newline at end of file
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Vec2.h"
+
+// an enemy or small enemy shot by a bullet
+struct EnemyKilled
+{
+	size_t id;
+	bool small;
+	int score; // what it was worth
+	Vec2 pos;
+};
+
+// a player (human or bot) ran into an enemy
+struct PlayerHit
+{
+	size_t id;
+	bool bot;
+	bool bySmallEnemy;
+	Vec2 pos;
+};
+
+// an entity was created, it joins the entity list at the next update
+struct Spawned
+{
+	size_t id;
+	std::string tag;
+};
+
+// Events of one type raised during a tick. Systems push into a plain array while they
+// run and dispatch() hands the whole tick's worth to every subscriber in one go, then
+// empties it (keeping the capacity, so a busy tick doesn't allocate the next time).
+// There is no lock: everything that pushes declares Access::Events so the scheduler
+// never runs two of them at once.
+template<typename T>
+class EventChannel
+{
+public:
+	typedef std::function<void(const std::vector<T>&)> Subscriber;
+
+private:
+	std::vector<T> m_events;
+	std::vector<Subscriber> m_subscribers;
+
+public:
+	void push(const T& event)
+	{
+		m_events.push_back(event);
+	}
+
+	void subscribe(Subscriber subscriber)
+	{
+		m_subscribers.push_back(std::move(subscriber));
+	}
+
+	void dispatch()
+	{
+		if (m_events.empty())
+		{
+			return;
+		}
+
+		for (auto& s : m_subscribers)
+		{
+			s(m_events);
+		}
+		m_events.clear();
+	}
+
+	// drop this tick's events without handing them out
+	void clear()
+	{
+		m_events.clear();
+	}
+
+	size_t size() const
+	{
+		return m_events.size();
+	}
+};
+
+// every gameplay channel, dispatched together once per tick
+struct GameEvents
+{
+	EventChannel<EnemyKilled> enemyKilled;
+	EventChannel<PlayerHit> playerHit;
+	EventChannel<Spawned> spawned;
+
+	void dispatch()
+	{
+		playerHit.dispatch();
+		enemyKilled.dispatch();
+		spawned.dispatch();
+	}
+
+	void clear()
+	{
+		playerHit.clear();
+		enemyKilled.clear();
+		spawned.clear();
+	}
+};
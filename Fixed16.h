@@ -0,0 +1,100 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+
+// Q16.16 fixed point number, 16 bits of whole number and 16 bits of fraction.
+// All the maths is done on integers so the same inputs give the same bits on every
+// compiler and cpu, which floats don't promise (fma, x87, fast-math and so on).
+// Range is about -32768 to 32767 with steps of 1/65536. Results past that wrap round
+// the same way on every machine: the maths is done in 64 bits and cut back to 32, which
+// C++20 defines, instead of overflowing an int32_t, which is undefined.
+//
+// Numbers only become fixed point on purpose, Fixed16(0.5f) rather than 0.5f, so a
+// float can't slip into the maths unnoticed.
+class Fixed16
+{
+public:
+
+	static constexpr int FracBits = 16;
+	static constexpr int32_t One = 1 << FracBits;
+
+	int32_t raw = 0;
+
+	constexpr Fixed16() {}
+	explicit constexpr Fixed16(int val) : raw(static_cast<int32_t>(static_cast<int64_t>(val) * One)) {}
+	explicit constexpr Fixed16(float val) : raw(static_cast<int32_t>(val * One + (val < 0 ? -0.5f : 0.5f))) {}
+	explicit constexpr Fixed16(double val) : raw(static_cast<int32_t>(val * One + (val < 0 ? -0.5 : 0.5))) {}
+
+	static constexpr Fixed16 fromRaw(int32_t r)
+	{
+		Fixed16 f;
+		f.raw = r;
+		return f;
+	}
+
+	constexpr float toFloat() const { return static_cast<float>(raw) / One; }
+	explicit constexpr operator float() const { return toFloat(); }
+
+	constexpr bool operator == (const Fixed16& rhs) const = default;
+	constexpr auto operator <=> (const Fixed16& rhs) const = default;
+
+	constexpr Fixed16 operator - () const { return fromRaw(static_cast<int32_t>(-static_cast<int64_t>(raw))); }
+	constexpr Fixed16 operator + (const Fixed16& rhs) const { return fromRaw(static_cast<int32_t>(static_cast<int64_t>(raw) + rhs.raw)); }
+	constexpr Fixed16 operator - (const Fixed16& rhs) const { return fromRaw(static_cast<int32_t>(static_cast<int64_t>(raw) - rhs.raw)); }
+
+	// products and quotients go through 64 bits so the fraction isn't thrown away first
+	constexpr Fixed16 operator * (const Fixed16& rhs) const
+	{
+		return fromRaw(static_cast<int32_t>((static_cast<int64_t>(raw) * rhs.raw) >> FracBits));
+	}
+
+	// dividing by zero is undefined, the same as for int
+	constexpr Fixed16 operator / (const Fixed16& rhs) const
+	{
+		return fromRaw(static_cast<int32_t>((static_cast<int64_t>(raw) << FracBits) / rhs.raw));
+	}
+
+	constexpr Fixed16& operator += (const Fixed16& rhs) { return *this = *this + rhs; }
+	constexpr Fixed16& operator -= (const Fixed16& rhs) { return *this = *this - rhs; }
+	constexpr Fixed16& operator *= (const Fixed16& rhs) { return *this = *this * rhs; }
+	constexpr Fixed16& operator /= (const Fixed16& rhs) { return *this = *this / rhs; }
+
+	// integer square root, one bit of the answer per loop, rounds down
+	static constexpr uint64_t isqrt(uint64_t v)
+	{
+		uint64_t result = 0;
+		uint64_t bit = uint64_t(1) << 62;
+
+		while (bit > v)
+		{
+			bit >>= 2;
+		}
+
+		while (bit != 0)
+		{
+			if (v >= result + bit)
+			{
+				v -= result + bit;
+				result = (result >> 1) + bit;
+			}
+			else
+			{
+				result >>= 1;
+			}
+			bit >>= 2;
+		}
+
+		return result;
+	}
+
+	// sqrt(raw / 2^16) * 2^16 = sqrt(raw * 2^16), negatives give 0
+	static constexpr Fixed16 sqrt(Fixed16 v)
+	{
+		if (v.raw <= 0)
+		{
+			return Fixed16();
+		}
+		return fromRaw(static_cast<int32_t>(isqrt(static_cast<uint64_t>(v.raw) << FracBits)));
+	}
+};
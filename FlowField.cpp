@@ -0,0 +1,263 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+
+#include "FlowField.h"
+
+FlowField::FlowField()
+{
+}
+
+FlowField::~FlowField()
+{
+	stopWorker();
+}
+
+void FlowField::resizeGrid(Grid& grid, int cols, int rows, float cellSize)
+{
+	grid.cols = cols;
+	grid.rows = rows;
+	grid.cellSize = cellSize;
+	size_t cells = static_cast<size_t>(cols) * rows;
+	grid.cost.assign(cells, 0);
+	grid.dirX.assign(cells, 0);
+	grid.dirY.assign(cells, 0);
+}
+
+void FlowField::resize(float width, float height, float cellSize)
+{
+	waitForJob();
+
+	cellSize = std::max(cellSize, 1.0f);
+	int cols = std::max(1, static_cast<int>(std::ceil(width / cellSize)));
+	int rows = std::max(1, static_cast<int>(std::ceil(height / cellSize)));
+
+	resizeGrid(m_front, cols, rows, cellSize);
+	resizeGrid(m_back, cols, rows, cellSize);
+	m_jobHandedOut = false; // built for the old grid
+}
+
+void FlowField::setRange(float range)
+{
+	waitForJob();
+
+	float cells = range > 0 ? range / m_front.cellSize : 0;
+	m_front.range = cells;
+	m_back.range = cells;
+	m_jobHandedOut = false; // built for the old range
+}
+
+void FlowField::setThreaded(bool threaded)
+{
+	if (threaded == m_threaded)
+	{
+		return;
+	}
+
+	if (threaded)
+	{
+		m_quit = false;
+		m_worker = std::thread(&FlowField::workerLoop, this);
+	}
+	else
+	{
+		stopWorker();
+	}
+	m_threaded = threaded;
+}
+
+void FlowField::update(const Vec2& target)
+{
+	if (m_front.cols == 0)
+	{
+		return;
+	}
+
+	if (!m_threaded)
+	{
+		build(m_front, target);
+		return;
+	}
+
+	// pick up the field built during the last frame, on the very first
+	// frame there is nothing to pick up so build one here. The worker's own
+	// flag is only read under the lock, in waitForJob
+	if (m_jobHandedOut)
+	{
+		waitForJob();
+		std::swap(m_front, m_back);
+	}
+	else
+	{
+		build(m_front, target);
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_jobTarget = target;
+	m_jobPending = true;
+	m_jobRunning = true;
+	m_jobHandedOut = true;
+	m_cv.notify_one();
+}
+
+Vec2 FlowField::sample(const Vec2& pos) const
+{
+	const Grid& g = m_front;
+	if (g.cols == 0)
+	{
+		return Vec2(0, 0);
+	}
+
+	int cx = std::clamp(static_cast<int>(pos.x / g.cellSize), 0, g.cols - 1);
+	int cy = std::clamp(static_cast<int>(pos.y / g.cellSize), 0, g.rows - 1);
+
+	int tx = std::clamp(static_cast<int>(g.target.x / g.cellSize), 0, g.cols - 1);
+	int ty = std::clamp(static_cast<int>(g.target.y / g.cellSize), 0, g.rows - 1);
+
+	// inside the target's own cell just head straight for it
+	if (cx == tx && cy == ty)
+	{
+		Vec2 d = g.target - pos;
+		float len = d.dist(Vec2(0, 0));
+		return len > 0 ? d / len : Vec2(0, 0);
+	}
+
+	size_t i = static_cast<size_t>(cy) * g.cols + cx;
+	return Vec2(g.dirX[i], g.dirY[i]);
+}
+
+void FlowField::build(Grid& g, const Vec2& target)
+{
+	const float inf = std::numeric_limits<float>::max();
+	const float diagonal = 1.41421356f;
+
+	g.target = target;
+	std::fill(g.cost.begin(), g.cost.end(), inf);
+	std::fill(g.dirX.begin(), g.dirX.end(), 0.0f);
+	std::fill(g.dirY.begin(), g.dirY.end(), 0.0f);
+	float maxCost = g.range > 0 ? g.range : inf;
+
+	int tx = std::clamp(static_cast<int>(target.x / g.cellSize), 0, g.cols - 1);
+	int ty = std::clamp(static_cast<int>(target.y / g.cellSize), 0, g.rows - 1);
+
+	// integration field, dijkstra over the 8-connected grid from the target cell
+	typedef std::pair<float, int> Node;
+	std::priority_queue<Node, std::vector<Node>, std::greater<Node>> open;
+	int start = ty * g.cols + tx;
+	g.cost[start] = 0;
+	open.push({ 0.0f, start });
+
+	static const int nx[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+	static const int ny[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+
+	while (!open.empty())
+	{
+		auto [c, i] = open.top();
+		open.pop();
+		if (c > g.cost[i])
+		{
+			continue;
+		}
+
+		int x = i % g.cols;
+		int y = i / g.cols;
+		for (int n = 0; n < 8; ++n)
+		{
+			int x2 = x + nx[n];
+			int y2 = y + ny[n];
+			if (x2 < 0 || y2 < 0 || x2 >= g.cols || y2 >= g.rows)
+			{
+				continue;
+			}
+
+			int j = y2 * g.cols + x2;
+			float c2 = c + (n < 4 ? 1.0f : diagonal);
+			if (c2 < g.cost[j] && c2 <= maxCost)
+			{
+				g.cost[j] = c2;
+				open.push({ c2, j });
+			}
+		}
+	}
+
+	// only cells inside the range have a cost, the rest keep a zero direction
+	int reach = g.range > 0 ? static_cast<int>(std::ceil(g.range)) + 1 : std::max(g.cols, g.rows);
+	int x0 = std::max(tx - reach, 0), x1 = std::min(tx + reach, g.cols - 1);
+	int y0 = std::max(ty - reach, 0), y1 = std::min(ty + reach, g.rows - 1);
+
+	// a neighbour outside the range counts as level with the cell itself
+	auto costOr = [&g, inf](int j, float own) { return g.cost[j] == inf ? own : g.cost[j]; };
+
+	// direction field, the downhill gradient of the cost (central differences,
+	// one sided at the edges) which is smoother than snapping to 8 directions
+	for (int y = y0; y <= y1; ++y)
+	{
+		for (int x = x0; x <= x1; ++x)
+		{
+			size_t i = static_cast<size_t>(y) * g.cols + x;
+			float own = g.cost[i];
+			if (own == inf)
+			{
+				continue;
+			}
+
+			int xl = std::max(x - 1, 0), xr = std::min(x + 1, g.cols - 1);
+			int yu = std::max(y - 1, 0), yd = std::min(y + 1, g.rows - 1);
+
+			float gx = costOr(y * g.cols + xr, own) - costOr(y * g.cols + xl, own);
+			float gy = costOr(yd * g.cols + x, own) - costOr(yu * g.cols + x, own);
+			float len = std::sqrt(gx * gx + gy * gy);
+
+			g.dirX[i] = len > 0 ? -gx / len : 0;
+			g.dirY[i] = len > 0 ? -gy / len : 0;
+		}
+	}
+}
+
+void FlowField::workerLoop()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	while (true)
+	{
+		m_cv.wait(lock, [this]() { return m_jobPending || m_quit; });
+		if (m_quit)
+		{
+			return;
+		}
+
+		m_jobPending = false;
+		Vec2 target = m_jobTarget;
+
+		lock.unlock();
+		build(m_back, target);
+		lock.lock();
+
+		m_jobRunning = false;
+		m_cv.notify_all();
+	}
+}
+
+void FlowField::waitForJob()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_cv.wait(lock, [this]() { return !m_jobRunning; });
+}
+
+void FlowField::stopWorker()
+{
+	if (!m_worker.joinable())
+	{
+		return;
+	}
+
+	waitForJob();
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_cv.notify_all();
+	m_worker.join();
+	m_threaded = false;
+	m_jobHandedOut = false;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Vec2.h"
+
+// Grid flow field toward a single target (the player).
+// Each cell stores the unit direction to walk to get closer to the target along
+// the integrated path cost, so any number of chasers can look up their heading in
+// O(1) instead of each one working out its own path.
+//
+// In threaded mode the field is built on a worker thread while the rest of the
+// frame runs and swapped in on the next update, so chasers steer toward where the
+// target was one frame ago.
+class FlowField
+{
+	struct Grid
+	{
+		int cols = 0;
+		int rows = 0;
+		float cellSize = 1;
+		float range = 0; // in cells, 0 = the whole grid
+		Vec2 target;
+		std::vector<float> cost; // integrated path cost to the target cell
+		std::vector<float> dirX; // direction of travel per cell
+		std::vector<float> dirY;
+	};
+
+	Grid m_front; // read by sample()
+	Grid m_back; // written by the worker
+
+	bool m_threaded = false;
+	std::thread m_worker;
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	bool m_jobPending = false; // a build of m_back has been requested
+	bool m_jobRunning = false; // the worker is building m_back, under m_mutex
+	bool m_jobHandedOut = false; // m_back was requested and not swapped in yet, game thread only
+	bool m_quit = false;
+	Vec2 m_jobTarget;
+
+	static void resizeGrid(Grid& grid, int cols, int rows, float cellSize);
+	static void build(Grid& grid, const Vec2& target);
+
+	void workerLoop();
+	void waitForJob();
+	void stopWorker();
+
+public:
+	FlowField();
+	~FlowField();
+	FlowField(const FlowField&) = delete;
+	FlowField& operator = (const FlowField&) = delete;
+
+	// cover an area of width x height starting at (0, 0)
+	void resize(float width, float height, float cellSize);
+	void setThreaded(bool threaded);
+
+	// only build the field within this distance of the target, 0 for everywhere.
+	// Cells further away have no direction, so chasers out there keep their heading
+	void setRange(float range);
+
+	// rebuild the field for a new target position, call once per tick
+	void update(const Vec2& target);
+
+	// unit direction toward the target from pos, zero if there is no field yet
+	Vec2 sample(const Vec2& pos) const;
+};
@@ -0,0 +1,74 @@
+#include "FrameGovernor.h"
+
+// how much of the budget counts as over / as headroom
+static const float OverBudget = 1.0f;
+static const float Headroom = 0.7f;
+
+// how many frames in a row before changing level, and how long to settle after
+static const int StepDownFrames = 10;
+static const int StepUpFrames = 120;
+static const int SettleFrames = 30;
+
+// weight of the newest frame in the average
+static const float Smoothing = 0.1f;
+
+FrameGovernor::FrameGovernor(float budgetMs)
+	: m_budgetMs(budgetMs)
+	, m_averageMs(budgetMs * 0.5f)
+{
+}
+
+void FrameGovernor::setBudget(float budgetMs)
+{
+	m_budgetMs = budgetMs;
+}
+
+float FrameGovernor::budget() const
+{
+	return m_budgetMs;
+}
+
+bool FrameGovernor::update(float frameMs)
+{
+	m_averageMs += (frameMs - m_averageMs) * Smoothing;
+
+	if (m_cooldown > 0)
+	{
+		--m_cooldown;
+		return false;
+	}
+
+	m_overFrames = m_averageMs > m_budgetMs * OverBudget ? m_overFrames + 1 : 0;
+	m_underFrames = m_averageMs < m_budgetMs * Headroom ? m_underFrames + 1 : 0;
+
+	int level = m_level;
+	if (m_overFrames >= StepDownFrames && m_level < MaxLevel)
+	{
+		++level;
+	}
+	else if (m_underFrames >= StepUpFrames && m_level > 0)
+	{
+		--level;
+	}
+
+	if (level == m_level)
+	{
+		return false;
+	}
+
+	m_level = level;
+	m_overFrames = 0;
+	m_underFrames = 0;
+	m_cooldown = SettleFrames;
+	return true;
+}
+
+int FrameGovernor::level() const
+{
+	return m_level;
+}
+
+float FrameGovernor::averageMs() const
+{
+	return m_averageMs;
+}
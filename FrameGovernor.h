@@ -0,0 +1,30 @@
+#pragma once
+
+// Watches how long frames take against a time budget and picks a quality level,
+// 0 is full quality and every level above gives up a bit more to win time back.
+// It steps down quickly when frames run over budget and only steps back up after
+// a longer stretch of frames with plenty of headroom, so it doesn't flicker
+// between levels.
+class FrameGovernor
+{
+	float m_budgetMs = 16.6f;
+	float m_averageMs = 0; // exponential moving average of the frame time
+	int m_level = 0;
+	int m_overFrames = 0; // consecutive frames over budget
+	int m_underFrames = 0; // consecutive frames with headroom
+	int m_cooldown = 0; // frames to wait after a change before judging again
+
+public:
+	static const int MaxLevel = 4;
+
+	FrameGovernor(float budgetMs = 16.6f);
+
+	void setBudget(float budgetMs);
+	float budget() const;
+
+	// feed the work time of the last frame, returns true if the level changed
+	bool update(float frameMs);
+
+	int level() const;
+	float averageMs() const;
+};
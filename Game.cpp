@@ -3,6 +3,10 @@
 #include <cstdlib>
 #include <random>
 #include <numbers>
+#include <algorithm>
+#include <limits>
+#include <filesystem>
+#include <span>
 
 #include "Game.h"
 
@@ -11,67 +15,77 @@ Game::Game(const std::string& config)
 	init(config);
 }
 
-void Game::init(const std::string& path)
+Game::Game(const std::string& config, const Scenario& scenario)
+	: m_headless(true), m_scenario(scenario)
 {
-	unsigned int winX = 1280;
-	unsigned int winY = 720;
-	unsigned int frameLimit = 60;
-	unsigned int winMode = 0;
-	int fontSize = 20;
-	int fontColorR = 255, fontColorG = 255, fontColorB = 255;
+	init(config);
+}
 
-	std::string fontPath;
-	std::string word;
-	std::ifstream fin(path);
+void Game::init(const std::string& path)
+{
+	m_configPath = path;
 
-	if (fin.is_open()) {
-		while (fin >> word) 
-		{
-			if (word == "Window")
-			{
-				fin >> winX >> winY >> frameLimit >> winMode;
-			}
-			else if (word == "Font")
-			{
-				fin >> fontPath >> fontSize >> fontColorR >> fontColorG >> fontColorB;
-			}
-			else if (word == "Player")
-			{
-				fin >> m_playerConfig.SR >> m_playerConfig.CR >> m_playerConfig.S >> m_playerConfig.FR
-					>> m_playerConfig.FG >> m_playerConfig.FB >> m_playerConfig.OR >> m_playerConfig.OG
-					>> m_playerConfig.OB >> m_playerConfig.OT >> m_playerConfig.V;
-			}
-			else if (word == "Enemy")
-			{
-				fin >> m_enemyConfig.SR >> m_enemyConfig.CR >> m_enemyConfig.SMIN >> m_enemyConfig.SMAX
-					>> m_enemyConfig.OR >> m_enemyConfig.OG >> m_enemyConfig.OB >> m_enemyConfig.OT >> m_enemyConfig.VMIN
-					>> m_enemyConfig.VMAX >> m_enemyConfig.L >> m_enemyConfig.SI;
-			}
-			else if (word == "Bullet")
-			{
-				fin >> m_bulletConfig.SR >> m_bulletConfig.CR >> m_bulletConfig.S >> m_bulletConfig.FR
-					>> m_bulletConfig.FG >> m_bulletConfig.FB >> m_bulletConfig.OR >> m_bulletConfig.OG
-					>> m_bulletConfig.OB >> m_bulletConfig.OT >> m_bulletConfig.V >> m_bulletConfig.L;
-			}
-		}
+	// config.bin is config.txt already parsed and checked (--compile-config), used while the text hasn't changed
+	GameConfig config;
+	std::vector<std::string> errors;
+	std::string compiled = std::filesystem::path(path).replace_extension(".bin").string();
+	if (!loadCompiledConfig(compiled, path, config) && !loadConfig(path, config, errors))
+	{
+		config = GameConfig();
 	}
 
-	fin.close();
-
-	// load background
-	if (!m_backgroundTexture.loadFromFile("galaxy2.jpg")) {
-		std::cout << "Error!! Failed to load background texture.\n";
+	// a scenario file can override anything in the config
+	if (m_headless && !loadConfig(m_scenario.path, config, errors, true))
+	{
+		config = GameConfig();
 	}
 
-	m_backgroundSprite.setTexture(m_backgroundTexture);
+	// a config with any error in it isn't used at all, the same as a reload, half of one
+	// could still have values the game can't run with
+	for (auto& e : errors)
+	{
+		std::cout << "Config error: " << e << "\n";
+	}
+	if (!errors.empty())
+	{
+		std::cout << "Config: starting with the default settings instead.\n";
+	}
 
-	// Scale the background sprite to fit the window
-	float scaleX = static_cast<float>(winX) / m_backgroundSprite.getLocalBounds().width;
-	float scaleY = static_cast<float>(winY) / m_backgroundSprite.getLocalBounds().height;
-	m_backgroundSprite.setScale(scaleX, scaleY);
+	// a rollback has to be able to put back everything a tick depends on
+	if (config.rollback.ON)
+	{
+		if (config.waves)
+		{
+			std::cout << "Rollback: ring waves are off, a wave script part way through a ring can't be rolled back.\n";
+		}
+		holdForRollback(config);
+	}
 
-	// Set the background sprite's position to (0, 0)
-	m_backgroundSprite.setPosition(sf::Vector2f(0, 0));
+	m_config = config;
+	m_playerConfig = config.player;
+	m_enemyConfig = config.enemy;
+	m_bulletConfig = config.bullet;
+	buildPrefabs();
+	m_chaseConfig = config.chase;
+	m_worldConfig = config.world;
+	m_scriptedWaves = config.waves != 0;
+	m_systemDebug = config.scheduler != 0;
+	m_governorOn = config.governor != 0;
+	m_starLayers = config.starfield;
+	m_metricsPort = config.metrics;
+	m_botCount = config.bots.N;
+	m_botStrategy = config.bots.S;
+	m_botSeed = config.bots.SD;
+	m_rollbackConfig = config.rollback;
+	m_regionsConfig = config.regions;
+
+	unsigned int winX = config.window.W;
+	unsigned int winY = config.window.H;
+	unsigned int frameLimit = config.window.FL;
+	unsigned int winMode = config.window.FS;
+	int fontSize = config.font.S;
+	int fontColorR = config.font.R, fontColorG = config.font.G, fontColorB = config.font.B;
+	std::string fontPath = config.font.F;
 
 	// load ttf font and set font
 	if (!m_font.loadFromFile(fontPath)) {
@@ -83,502 +97,1767 @@ void Game::init(const std::string& path)
 	m_text.setPosition(0, 0);
 	m_text.setString("Score: " + std::to_string(m_score));
 
-	// set up window parameters ( 0=user defined window size, 1=full window size )
-	if (winMode == 0)
+	// set up window parameters ( 0=user defined window size, 1=full window size ), no window when headless
+	sf::Vector2u screenSize(winX, winY);
+	if (!m_headless && winMode == 0)
 	{
 		m_window.create(sf::VideoMode(winX, winY), "Chipmore Galaxy Wars");
 		m_window.setFramerateLimit(frameLimit);
 	}
-	else if(winMode == 1)
+	else if(!m_headless && winMode == 1)
 	{
 		auto fullscreenMode{ sf::VideoMode::getFullscreenModes() };
 		m_window.create(fullscreenMode[0], "Chipmore Galaxy Wars", sf::Style::Fullscreen);
 		m_window.setFramerateLimit(frameLimit);
 	}
 
+	if (!m_headless)
+	{
+		screenSize = m_window.getSize();
+
+		// load background, scaled to fit the window once here rather than every frame
+		m_background.load("galaxy2.jpg", screenSize.x, screenSize.y);
+		m_background.setStarfield(m_starLayers, 1234);
+	}
+
+	// the world is the window unless the config asks for more, the camera shows one window's worth of it
+	m_worldSize = m_worldConfig.W > 0 && m_worldConfig.H > 0 ? sf::Vector2u(m_worldConfig.W, m_worldConfig.H) : screenSize;
+	m_camera = sf::View(sf::FloatRect(0, 0, static_cast<float>(screenSize.x), static_cast<float>(screenSize.y)));
+	m_hudView = m_camera;
+
+	// the governor aims to finish a frame's work inside one frame at the frame limit
+	m_governor.setBudget(frameLimit > 0 ? 1000.0f / frameLimit : 1000.0f / 60.0f);
+
+	// the regions cover the whole play area too, anything outside belongs to the one nearest
+	if (m_regionsConfig.ON)
+	{
+		m_regions.resize(m_regionsConfig.C, m_regionsConfig.R, static_cast<float>(m_worldSize.x), static_cast<float>(m_worldSize.y));
+		std::cout << "Regions: the world is simulated as " << m_regions.size() << " regions.\n";
+	}
+
+	// the flow field covers the whole play area
+	if (m_chaseConfig.ON)
+	{
+		m_flowField.resize(static_cast<float>(m_worldSize.x), static_cast<float>(m_worldSize.y), static_cast<float>(m_chaseConfig.CS));
+		m_flowField.setThreaded(m_chaseConfig.MT != 0);
+
+		// enemies past the far distance don't chase, so the field stops there too
+		m_flowField.setRange(static_cast<float>(m_worldConfig.FD));
+	}
+
 	spawnPlayer();
-}
 
-void Game::run()
-{
-	while (m_running)
+	for (int i = 0; i < m_botCount; ++i)
+	{
+		auto strategy = makeBotStrategy(m_botStrategy, i);
+		if (!strategy)
+		{
+			std::cout << "Error!! Unknown bot strategy " << m_botStrategy << ".\n";
+			break;
+		}
+		spawnBot(std::make_shared<CBot>(strategy, m_botSeed + i, i));
+	}
+
+	// the loopback peer is a bot driven by the input that arrives from it, index 0 so view.frame is the tick
+	if (m_rollbackConfig.ON)
+	{
+		size_t ticks = static_cast<size_t>(m_rollbackConfig.N);
+		m_snapshots.resize(ticks);
+		m_localInputs.assign(ticks, BotAction());
+		m_peerInputs.resize(ticks * 2);
+		m_peer.start(m_botSeed + 1000, m_rollbackConfig.D, Vec2(static_cast<float>(m_worldSize.x), static_cast<float>(m_worldSize.y)));
+		spawnBot(std::make_shared<CBot>(std::make_shared<RemoteStrategy>(m_peerInputs), m_botSeed + 1000, 0));
+	}
+
+	// the regular spawner is itself a wave script
+	m_waves.start(regularWave());
+	if (m_scriptedWaves)
+	{
+		m_waves.start(ringWave());
+	}
+
+	if (m_headless)
 	{
-		m_entities.update();
+		// same enemies every run, and nothing changes the workload part way through
+		m_rng.seed(m_scenario.seed);
+		m_governorOn = false;
 
-		if (!m_paused)
+		for (int i = 0; i < m_scenario.enemies; ++i)
 		{
-			sLifespan();
-			sEnemySpawner();
-			sMovement();
-			sCollision();
+			spawnEnemy();
 		}
+		m_waves.start(firingPattern());
+	}
 
-		sUserInput();
-		sRender();
+	registerSystems();
+	startMetrics();
+}
 
-		// increment the current frame
-		// may need to be moved when pause implement
-		m_currentFrame++;
+void Game::holdForRollback(GameConfig& config)
+{
+	config.waves = 0; // the ring script keeps its place in locals
+	config.chase.MT = 0; // the threaded field is always one tick behind, from a target a rollback would have changed
+	config.governor = 0; // the spawn interval would follow the frame time instead of the tick
+}
+
+void Game::applyConfig(const GameConfig& reloaded)
+{
+	// the same settings stay off as at startup, a reload can't turn them back on under a rollback
+	GameConfig config = reloaded;
+	if (m_rollbackConfig.ON)
+	{
+		holdForRollback(config);
+	}
+
+	// spawns from here on use the new values, what is already on screen stays as it is
+	m_playerConfig = config.player;
+	m_enemyConfig = config.enemy;
+	m_bulletConfig = config.bullet;
+	buildPrefabs();
+
+	if (config.window.FL != m_config.window.FL)
+	{
+		m_window.setFramerateLimit(config.window.FL);
+		m_governor.setBudget(config.window.FL > 0 ? 1000.0f / config.window.FL : 1000.0f / 60.0f);
+	}
+
+	bool governorOn = config.governor != 0;
+	if (governorOn != m_governorOn)
+	{
+		// back to full quality, the governor starts from scratch if it is turned on again
+		m_governorOn = governorOn;
+		m_governor = FrameGovernor(m_governor.budget());
+		setQuality(0);
+	}
+
+	m_worldConfig.FD = config.world.FD;
+	m_worldConfig.FT = config.world.FT;
+
+	// the flow field waits for any build in flight before it changes
+	if (config.chase.ON && (!(config.chase == m_chaseConfig) || config.world.FD != m_config.world.FD))
+	{
+		m_flowField.resize(static_cast<float>(m_worldSize.x), static_cast<float>(m_worldSize.y), static_cast<float>(config.chase.CS));
+		m_flowField.setThreaded(config.chase.MT != 0);
+		m_flowField.setRange(static_cast<float>(config.world.FD));
+	}
+	m_chaseConfig = config.chase;
+
+	// these are only read while starting up
+	std::vector<std::string> restart;
+	if (config.window.W != m_config.window.W || config.window.H != m_config.window.H || config.window.FS != m_config.window.FS)
+	{
+		restart.push_back("Window");
+	}
+	if (!(config.font == m_config.font))
+	{
+		restart.push_back("Font");
+	}
+	if (config.world.W != m_config.world.W || config.world.H != m_config.world.H)
+	{
+		restart.push_back("World size");
+	}
+	if (!(config.bots == m_config.bots))
+	{
+		restart.push_back("Bots");
+	}
+	if (config.waves != m_config.waves)
+	{
+		restart.push_back("Waves");
+	}
+	if (config.scheduler != m_config.scheduler)
+	{
+		restart.push_back("Scheduler");
+	}
+	if (config.starfield != m_config.starfield)
+	{
+		restart.push_back("Starfield");
+	}
+	if (config.metrics != m_config.metrics)
+	{
+		restart.push_back("Metrics");
+	}
+	if (!(config.rollback == m_config.rollback))
+	{
+		restart.push_back("Rollback");
+	}
+	if (!(config.regions == m_config.regions))
+	{
+		restart.push_back("Regions");
+	}
+
+	std::cout << "Config reloaded";
+	for (size_t i = 0; i < restart.size(); ++i)
+	{
+		std::cout << (i == 0 ? ", needs a restart for: " : ", ") << restart[i];
+	}
+	std::cout << "\n";
+
+	// m_config keeps the startup values of everything not applied, so those are reported until they match again
+	m_config.window.FL = config.window.FL;
+	m_config.player = config.player;
+	m_config.enemy = config.enemy;
+	m_config.bullet = config.bullet;
+	m_config.chase = config.chase;
+	m_config.world.FD = config.world.FD;
+	m_config.world.FT = config.world.FT;
+	m_config.governor = config.governor;
+	m_config.reload = config.reload;
+
+	// Reload 0 stops watching, it can only be turned back on by a restart
+	if (!config.reload)
+	{
+		m_configWatcher.stop();
 	}
 }
 
-void Game::setPaused(bool paused)
+void Game::startMetrics()
 {
-	m_paused = paused;
+	if (m_metricsPort <= 0)
+	{
+		return;
+	}
+
+	for (auto tag : { "player", "enemy", "smallEnemy", "bullet" })
+	{
+		m_entityGauges.push_back({ tag, &m_metrics.gauge(std::string("entities{tag=\"") + tag + "\"}") });
+	}
+	m_particleGauge = &m_metrics.gauge("particles");
+	m_scoreGauge = &m_metrics.gauge("score");
+	m_frameGauge = &m_metrics.gauge("frame");
+	m_qualityGauge = &m_metrics.gauge("quality_level");
+	m_spawnedCounter = &m_metrics.counter("entities_spawned");
+	m_destroyedCounter = &m_metrics.counter("entities_destroyed");
+	m_killCounter = &m_metrics.counter("enemies_killed");
+	m_playerHitCounter = &m_metrics.counter("player_hits");
+
+	// counted straight off the event batches
+	m_events.enemyKilled.subscribe([this](const std::vector<EnemyKilled>& batch)
+	{
+		m_killCounter->fetch_add(batch.size(), std::memory_order_relaxed);
+	});
+	m_events.playerHit.subscribe([this](const std::vector<PlayerHit>& batch)
+	{
+		m_playerHitCounter->fetch_add(batch.size(), std::memory_order_relaxed);
+	});
+
+	m_metrics.histogram("tick", m_tickTime);
+	for (size_t i = 0; i < m_systems.size(); ++i)
+	{
+		m_metrics.histogram("system_" + m_systems.name(i), m_systems.timeHistogram(i));
+	}
+
+	m_metrics.start(static_cast<unsigned short>(m_metricsPort));
 }
 
-// respawn the player in the middle of the screen
-void Game::spawnPlayer()
+void Game::publishMetrics()
 {
-	// We create every entity by calling EntityManager.addEntity(tag)
-	// This returns a std::shared_ptr<Entity>, so we use 'auto' to save typing
-	auto entity = m_entities.addEntity("player");
+	if (!m_metrics.running())
+	{
+		return;
+	}
 
-	// Give this entity a Transform so it spawns at (200, 200) with velocity (1, 1) and angle 0
-	// Spawn at the middle of window
-	float mx = m_window.getSize().x / 2.0f;
-	float my = m_window.getSize().y / 2.0f;
+	// plain relaxed stores, the server thread does everything else
+	for (auto& [tag, gauge] : m_entityGauges)
+	{
+		gauge->store(m_entities.getEntities(tag).size(), std::memory_order_relaxed);
+	}
+	m_particleGauge->store(m_particles.count(), std::memory_order_relaxed);
+	m_scoreGauge->store(m_score, std::memory_order_relaxed);
+	m_frameGauge->store(m_currentFrame, std::memory_order_relaxed);
+	m_qualityGauge->store(m_governor.level(), std::memory_order_relaxed);
+	m_spawnedCounter->store(m_entities.totalCreated(), std::memory_order_relaxed);
+	m_destroyedCounter->store(m_entities.totalRemoved(), std::memory_order_relaxed);
+}
 
-	entity->cTransform = std::make_shared<CTransform>(Vec2(mx, my), Vec2(m_playerConfig.S, m_playerConfig.S), 0.0f);
-	entity->cShape = std::make_shared<CShape>(m_playerConfig.SR, m_playerConfig.V,
-		sf::Color(m_playerConfig.FR, m_playerConfig.FG, m_playerConfig.FB),
-		sf::Color(m_playerConfig.OR, m_playerConfig.OG, m_playerConfig.OB), m_playerConfig.OT);
-	entity->cCollision = std::make_shared<CCollision>(m_playerConfig.CR);
+void Game::registerSystems()
+{
+	auto running = [this]() { return !m_paused; };
+	auto shown = [this]() { return !m_paused && !m_resimulating; };
+	auto live = [this]() { return !m_resimulating; };
+
+	// registration order is the order systems that touch the same data run in,
+	// systems with nothing in common run at the same time.
+	// input comes first so anything it spawns is added by the update below
+	// and simulated / drawn this frame instead of the next one
+	m_systems.add({ "userInput", Access::Transform | Access::EntityList | Access::Camera, Access::InputQueue | Access::Input | Access::GameState | Access::Spawn | Access::Events,
+		[this]() { sUserInput(); }, false, nullptr });
+	m_systems.add({ "entityUpdate", Access::Alive, Access::EntityList | Access::Spawn,
+		[this]() { m_entities.update(); }, false, nullptr });
+
+	if (!m_regionsConfig.ON)
+	{
+		m_systems.add({ "lifespan", Access::EntityList, Access::Lifespan | Access::Shape | Access::Alive,
+			[this]() { sLifespan(); }, false, running });
+	}
+	m_systems.add({ "enemySpawner", Access::EntityList | Access::Transform | Access::Alive | Access::Window, Access::Waves | Access::Spawn | Access::GameState | Access::Random | Access::Events,
+		[this]() { sEnemySpawner(); }, false, running });
+	m_systems.add({ "flowField", Access::Transform | Access::GameState, Access::FlowField,
+		[this]() { sFlowField(); }, false, running });
+	// sharded, lifespan moves down to here with the movement, nothing between them looks at what it changes
+	if (m_regionsConfig.ON)
+	{
+		m_systems.add({ "regions", Access::EntityList | Access::Input | Access::FlowField | Access::GameState | Access::Camera, Access::Transform | Access::Shape | Access::Lifespan | Access::Alive,
+			[this]() { sRegions(); }, false, running });
+	}
+	else
+	{
+		m_systems.add({ "movement", Access::EntityList | Access::Input | Access::FlowField | Access::GameState | Access::Camera, Access::Transform | Access::Shape,
+			[this]() { sMovement(); }, false, running });
+	}
+	m_systems.add({ "spatialIndex", Access::EntityList | Access::Transform | Access::Collision | Access::Alive, Access::SpatialIndex,
+		[this]() { sSpatialIndex(); }, false, running });
+	m_systems.add({ "collision", Access::EntityList | Access::SpatialIndex | Access::Collision | Access::Score | Access::Shape | Access::Window, Access::Transform | Access::Alive | Access::GameState | Access::Spawn | Access::Particles | Access::Events | Access::Bot,
+		[this]() { m_regionsConfig.ON ? sRegionCollision() : sCollision(); }, false, running });
+	m_systems.add({ "homing", Access::EntityList | Access::SpatialIndex | Access::Homing | Access::Alive, Access::Transform,
+		[this]() { sHoming(); }, false, running });
+	m_systems.add({ "bots", Access::EntityList | Access::SpatialIndex | Access::Transform | Access::Alive | Access::GameState, Access::Input | Access::Spawn | Access::Bot | Access::Events,
+		[this]() { sBots(); }, false, running });
+	m_systems.add({ "camera", Access::Transform | Access::GameState | Access::Window, Access::Camera,
+		[this]() { sCamera(); }, false, nullptr });
+	m_systems.add({ "events", Access::Score | Access::GameState, Access::Events | Access::Window,
+		[this]() { sEvents(); }, false, nullptr });
+	m_systems.add({ "particles", Access::None, Access::Particles,
+		[this]() { sParticles(); }, false, shown });
+
+	// SFML wants window events and drawing on the thread that made the window
+	// headless runs have neither
+	if (!m_headless)
+	{
+		m_systems.add({ "windowEvents", Access::None, Access::Window | Access::GameState | Access::InputQueue | Access::Camera | Access::FlowField,
+			[this]() { sWindowEvents(); }, true, live });
+		m_systems.add({ "render", Access::EntityList | Access::Camera, Access::Window | Access::Transform | Access::Shape | Access::GameState | Access::Particles,
+			[this]() { sRender(); }, true, live });
+	}
 
-	// Add an input component to the player so that we can use inputs
-	entity->cInput = std::make_shared<CInput>();
+	if (m_systemDebug)
+	{
+		m_systems.setDebug(true, [this](AccessMask data) { return fingerprint(data); });
+	}
+}
 
-	// Since we want this Entity to be our player, set our Game's player variable to be this Entity
-	// This goes slightly against the EntityManager paradigm, but we use the player so much it's worth it
-	m_player = entity;
+// FNV-1a over whatever bytes make up one kind of data
+uint64_t Game::fingerprint(AccessMask data)
+{
+	uint64_t hash = 14695981039346656037ull;
+	auto mix = [&hash](const void* p, size_t n)
+	{
+		auto bytes = static_cast<const unsigned char*>(p);
+		for (size_t i = 0; i < n; ++i)
+		{
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+	};
+
+	switch (data)
+	{
+	case Access::EntityList:
+	case Access::Alive:
+		for (auto& e : m_entities.getEntities())
+		{
+			size_t id = e->id();
+			bool active = e->isActive();
+			mix(&id, sizeof(id));
+			if (data == Access::Alive)
+			{
+				mix(&active, sizeof(active));
+			}
+		}
+		break;
+	case Access::Spawn:
+	{
+		size_t total = m_entities.totalCreated();
+		mix(&total, sizeof(total));
+		break;
+	}
+	case Access::GameState:
+	{
+		bool paused = m_paused;
+		mix(&m_score, sizeof(m_score));
+		mix(&m_currentFrame, sizeof(m_currentFrame));
+		mix(&m_lastEnemySpawnTime, sizeof(m_lastEnemySpawnTime));
+		mix(&paused, sizeof(paused));
+		mix(&m_running, sizeof(m_running));
+		auto player = m_player.get();
+		mix(&player, sizeof(player));
+		break;
+	}
+	case Access::Random:
+		mix(&m_rng, sizeof(m_rng));
+		break;
+	case Access::Particles:
+	{
+		size_t count = m_particles.count();
+		mix(&count, sizeof(count));
+		break;
+	}
+	case Access::Events:
+	{
+		size_t counts[3] = { m_events.enemyKilled.size(), m_events.playerHit.size(), m_events.spawned.size() };
+		mix(counts, sizeof(counts));
+		break;
+	}
+	case Access::Camera:
+	{
+		sf::Vector2f center = m_camera.getCenter();
+		sf::Vector2f size = m_camera.getSize();
+		mix(&center, sizeof(center));
+		mix(&size, sizeof(size));
+		break;
+	}
+	default:
+		for (auto& e : m_entities.getEntities())
+		{
+			if (data == Access::Transform && e->cTransform)
+			{
+				mix(&e->cTransform->pos, sizeof(Vec2));
+				mix(&e->cTransform->velocity, sizeof(Vec2));
+				mix(&e->cTransform->angle, sizeof(float));
+			}
+			else if (data == Access::Shape && e->cShape)
+			{
+				sf::Color fill = e->cShape->circle.getFillColor();
+				sf::Color outline = e->cShape->circle.getOutlineColor();
+				float rotation = e->cShape->circle.getRotation();
+				mix(&fill, sizeof(fill));
+				mix(&outline, sizeof(outline));
+				mix(&rotation, sizeof(rotation));
+			}
+			else if (data == Access::Collision && e->cCollision)
+			{
+				mix(&e->cCollision->radius, sizeof(float));
+			}
+			else if (data == Access::Input && e->cInput)
+			{
+				bool keys[5] = { e->cInput->up, e->cInput->left, e->cInput->right, e->cInput->down, e->cInput->shoot };
+				mix(keys, sizeof(keys));
+			}
+			else if (data == Access::Score && e->cScore)
+			{
+				mix(&e->cScore->score, sizeof(int));
+			}
+			else if (data == Access::Lifespan && e->cLifespan)
+			{
+				mix(&e->cLifespan->remaining, sizeof(int));
+			}
+			else if (data == Access::Homing && e->cHoming)
+			{
+				mix(&e->cHoming->turnRate, sizeof(float));
+			}
+			else if (data == Access::Bot && e->cBot)
+			{
+				// the next number a copy of the generator gives changes with every draw
+				std::minstd_rand rng = e->cBot->rng;
+				auto next = rng();
+				mix(&e->cBot->heading, sizeof(Vec2));
+				mix(&next, sizeof(next));
+			}
+		}
+		// Window, InputQueue, Waves, FlowField and SpatialIndex can't be hashed cheaply and are not checked
+		break;
+	}
 
+	return hash;
 }
 
-// spawn an enemy at a random position
-void Game::spawnEnemy()
+void Game::run()
+{
+	m_input.start(m_window);
+	if (m_config.reload)
+	{
+		m_configWatcher.start(m_configPath);
+	}
+
+	GameConfig reloaded;
+	while (m_running)
+	{
+		// a changed config is swapped in here, between ticks, so no system sees it change part way
+		if (m_configWatcher.take(reloaded))
+		{
+			applyConfig(reloaded);
+		}
+
+		// runs every system, see registerSystems for the order
+		m_frameStart = std::chrono::steady_clock::now();
+		if (m_rollbackConfig.ON)
+		{
+			rollbackTick();
+		}
+		m_systems.run();
+		m_tickTime.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_frameStart).count());
+		publishMetrics();
+
+		// increment the current frame
+		// may need to be moved when pause implement
+		m_currentFrame++;
+	}
+
+	m_input.stop();
+	m_configWatcher.stop();
+	m_metrics.stop();
+
+	std::cout << "Input latency\n";
+	m_inputToSpawn.print(std::cout);
+	m_inputToPresent.print(std::cout);
+	if (m_input.dropped() > 0)
+	{
+		std::cout << m_input.dropped() << " input events dropped (queue full)\n";
+	}
+}
+
+BenchmarkReport Game::runBenchmark()
 {
-	auto entity = m_entities.addEntity("enemy");
+	BenchmarkReport report;
+	report.scenario = m_scenario.name;
+	report.ticks = m_scenario.ticks;
 
-	// Give this entity a Transform so it spawns at (200, 200) with velocity (1, 1) and angle 0
-	// spawn at random position
-	float ex = rand() % m_window.getSize().x;
-	float ey = rand() % m_window.getSize().y;
+	// exact percentiles need every sample, the histogram only knows powers of two
+	std::vector<double> tickUs;
+	tickUs.reserve(m_scenario.ticks);
 
-	// Randomize enemy shape vertices
-	int eV = m_enemyConfig.VMIN + (std::rand() % (m_enemyConfig.VMAX - m_enemyConfig.VMIN + 1));
+	uint64_t allocationsBefore = Allocations::count();
+	uint64_t bytesBefore = Allocations::bytes();
+	auto start = std::chrono::steady_clock::now();
 
-	// Randomize enemy speed between SMIN & SMAX
-	float r = (float)rand() / (float)RAND_MAX;
-	float eS = m_enemyConfig.SMIN + r * (m_enemyConfig.SMAX - m_enemyConfig.SMIN);
+	for (int i = 0; i < m_scenario.ticks && m_running; ++i)
+	{
+		m_frameStart = std::chrono::steady_clock::now();
+		if (m_rollbackConfig.ON)
+		{
+			rollbackTick();
+		}
+		m_systems.run();
+		auto tickEnd = std::chrono::steady_clock::now();
 
-	// Randomize enemy shape color
-	int eShapeColR = 0 + (std::rand() % (255 - 0 + 1));
-	int eShapeColG = 0 + (std::rand() % (255 - 0 + 1));
-	int eShapeColB = 0 + (std::rand() % (255 - 0 + 1));
+		tickUs.push_back(std::chrono::duration<double, std::micro>(tickEnd - m_frameStart).count());
+		m_tickTime.record(std::chrono::duration_cast<std::chrono::microseconds>(tickEnd - m_frameStart).count());
+		report.peakEntities = std::max(report.peakEntities, m_entities.getEntities().size());
+		publishMetrics();
 
-	entity->cTransform = std::make_shared<CTransform>(Vec2(ex, ey), Vec2(eS, eS), 0.0f);
-	entity->cShape = std::make_shared<CShape>(m_enemyConfig.SR, eV, 
-						sf::Color(eShapeColR, eShapeColG, eShapeColB), 
-						sf::Color(m_enemyConfig.OR, m_enemyConfig.OG, m_enemyConfig.OB), m_enemyConfig.OT);
-	entity->cScore = std::make_shared<CScore>(100);
-	entity->cCollision = std::make_shared<CCollision>(m_enemyConfig.CR);
+		m_currentFrame++;
+	}
 
-	// record when the most recent enemy was spawned
-	m_lastEnemySpawnTime = m_currentFrame;
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	report.allocations = Allocations::count() - allocationsBefore;
+	report.allocatedBytes = Allocations::bytes() - bytesBefore;
+	m_metrics.stop();
+
+	report.ticks = static_cast<int>(tickUs.size());
+	if (!tickUs.empty())
+	{
+		report.ticksPerSecond = report.ticks / report.seconds;
+
+		auto percentile = [&tickUs](double p)
+		{
+			auto nth = tickUs.begin() + static_cast<size_t>(p / 100.0 * (tickUs.size() - 1));
+			std::nth_element(tickUs.begin(), nth, tickUs.end());
+			return *nth;
+		};
+		report.p50 = percentile(50);
+		report.p99 = percentile(99);
+		report.max = *std::max_element(tickUs.begin(), tickUs.end());
+	}
+
+	return report;
 }
 
-// spawn the small enemies when a big one (input entity e) explodes
-void Game::spawnSmallEnemies(std::shared_ptr<Entity> parent)
+void Game::saveSnapshot(GameSnapshot& snapshot)
 {
-	// when we create the smaller enemy, we have to read the values of the original enemy
-	// - spawn a number of small enemies equal to the vertices of the original enemy
-	// - set each small enemy to the same color as the original, half the size
-	// - small enemies are worth double points of the original enemy
+	m_entities.save(snapshot.entities);
+	m_waves.save(snapshot.waves);
+	snapshot.rng = m_rng;
+	snapshot.player = m_player;
+	snapshot.camera = m_camera.getCenter();
+	snapshot.score = m_score;
+	snapshot.currentFrame = m_currentFrame;
+	snapshot.lastEnemySpawnTime = m_lastEnemySpawnTime;
+	snapshot.spawnIntervalScale = m_spawnIntervalScale;
+}
 
-	// Get the number of vertices of the original enemy
-	size_t vertices = parent->cShape->circle.getPointCount();
+bool Game::restoreSnapshot(GameSnapshot& snapshot)
+{
+	// the only part that can refuse, so it goes first
+	if (!m_waves.restore(snapshot.waves))
+	{
+		return false;
+	}
 
-	// Get the position of the parent enemy
-	Vec2 parentPos = parent->cTransform->pos;
+	m_entities.restore(snapshot.entities);
+	m_rng = snapshot.rng;
+	m_player = snapshot.player;
+	m_camera.setCenter(snapshot.camera);
+	m_score = snapshot.score;
+	m_currentFrame = snapshot.currentFrame;
+	m_lastEnemySpawnTime = snapshot.lastEnemySpawnTime;
+	m_spawnIntervalScale = snapshot.spawnIntervalScale;
+
+	// the restored entities are placed in regions again from where they are now
+	m_regions.reset();
+	return true;
+}
 
-	// Get the velocity of the parent enemy
-    Vec2 parentVelocity = parent->cTransform->velocity;
+void Game::resolveRemoteInput()
+{
+	// earliest tick that was simulated with a wrong guess
+	int from = m_currentFrame;
+	int frame = 0;
+	BotAction input;
+	while (m_peer.receive(m_currentFrame, frame, input))
+	{
+		if (m_peerInputs.confirm(frame, input))
+		{
+			from = std::min(from, frame);
+		}
+	}
 
-	//Set each enemy to the same color as the original, half the size
-	sf::Color parentFill = parent->cShape->circle.getFillColor();
-	sf::Color parentOutline = parent->cShape->circle.getOutlineColor();
-	float parentThickness = parent->cShape->circle.getOutlineThickness();
+	if (from == m_currentFrame)
+	{
+		return;
+	}
 
-	float smallEnemyRadius = parent->cShape->circle.getRadius() * 0.5f;
-	float smallEnemyCollisionRadius = parent->cCollision->radius * 0.5f;
+	auto start = std::chrono::steady_clock::now();
+	int now = m_currentFrame;
 
-	float angle = 0;
+	GameSnapshot* snapshot = m_snapshots.find(from);
+	if (!snapshot || !restoreSnapshot(*snapshot))
+	{
+		// too late to correct, the peer's view and ours have drifted apart from here on
+		++m_lateInputs;
+		return;
+	}
 
-	for (size_t i = 0; i < vertices; ++i)
+	// play the ticks again with what we know now, saving each one as it goes
+	m_resimulating = true;
+	while (m_currentFrame < now)
 	{
-		auto smallEnemy = m_entities.addEntity("smallEnemy");
+		saveSnapshot(m_snapshots.write(m_currentFrame));
+		m_systems.run();
+		m_currentFrame++;
+	}
+	m_resimulating = false;
 
-		// Set the score of the small enemy to double the score of the original enemy
-		smallEnemy->cScore = std::make_shared<CScore>(parent->cScore->score * 2);
+	++m_rollbacks;
+	m_resimulatedTicks += now - from;
+	m_rollbackTime.record(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
 
-		// Set the shape of the small enemy
-		smallEnemy->cShape = std::make_shared<CShape>(smallEnemyRadius, vertices, parentFill, parentOutline, parentThickness);
+void Game::rollbackTick()
+{
+	// the peer plays this tick on its side, its input reaches us D ticks from now
+	m_peer.send(m_currentFrame);
 
-		// Set the collision radius of the small enemy
-		smallEnemy->cCollision = std::make_shared<CCollision>(smallEnemyCollisionRadius);
+	resolveRemoteInput();
+	saveSnapshot(m_snapshots.write(m_currentFrame));
+}
 
-		// Set the lifespan of the small enemy
-		int smallEnemyLifeSpan = m_enemyConfig.L - 50;
-		smallEnemy->cLifespan = std::make_shared<CLifespan>(smallEnemyLifeSpan);
+bool Game::setPeerDelay(int ticks)
+{
+	// the same limit validate() puts on Rollback D, the peer's input is only kept for 2N ticks
+	if (ticks < 0 || ticks >= m_rollbackConfig.N)
+	{
+		return false;
+	}
+	m_peer.setDelay(ticks);
+	return true;
+}
+
+void Game::settle()
+{
+	if (!m_rollbackConfig.ON)
+	{
+		return;
+	}
+
+	int delay = m_peer.delay();
+	m_peer.setDelay(0);
+	resolveRemoteInput();
+	m_peer.setDelay(delay);
+}
+
+uint64_t Game::stateChecksum()
+{
+	// the entity list fingerprint covers ids, the transform one positions and velocities
+	uint64_t hash = fingerprint(Access::EntityList) ^ (fingerprint(Access::Transform) * 31);
+	return hash ^ (static_cast<uint64_t>(m_score) * 1099511628211ull) ^ m_entities.totalCreated();
+}
+
+void Game::printRollbackStats(std::ostream& out) const
+{
+	out << m_rollbacks << " rollbacks, " << m_resimulatedTicks << " ticks resimulated, "
+		<< m_lateInputs << " inputs too late to correct\n";
+	if (m_rollbacks > 0)
+	{
+		m_rollbackTime.print(out);
+	}
+}
+
+void Game::setPaused(bool paused)
+{
+	m_paused = paused;
+}
+
+void Game::buildPrefabs()
+{
+	const BulletConfig& b = m_bulletConfig;
+	m_bulletPrefab = Prefab("bullet");
+	m_bulletPrefab.transform.emplace(Vec2(0, 0), Vec2(0, 0), 0.0f);
+	m_bulletPrefab.shape.emplace(b.SR, b.V, sf::Color(b.FR, b.FG, b.FB), sf::Color(b.OR, b.OG, b.OB), b.OT);
+	m_bulletPrefab.collision.emplace(b.CR);
+	m_bulletPrefab.lifespan.emplace(b.L);
+
+	// my ulti is pink color square shape pillow, it curves toward the closest enemy after leaving the player
+	m_specialPrefab = Prefab("bullet");
+	m_specialPrefab.transform.emplace(Vec2(0, 0), Vec2(0, 0), 0.0f);
+	m_specialPrefab.shape.emplace(20, 4, sf::Color(255, 160, 122), sf::Color(205, 92, 92), b.OT);
+	m_specialPrefab.collision.emplace(b.CR);
+	m_specialPrefab.lifespan.emplace(b.L);
+	m_specialPrefab.homing.emplace(b.HT, b.HR);
+
+	// one for every vertex count an enemy can have, the fill is random so it is set per spawn.
+	// The tables never shrink, an enemy spawned before a reload lowered VMAX still finds
+	// its own when it splits, and they are never resized anywhere else so references stay good
+	size_t counts = std::max(static_cast<size_t>(m_enemyConfig.VMAX) + 1, m_enemyPrefabs.size());
+	m_enemyPrefabs.assign(counts, Prefab());
+	m_smallEnemyPrefabs.assign(counts, Prefab());
+	for (size_t v = 3; v < counts; ++v)
+	{
+		buildEnemyPrefab(m_enemyPrefabs[v], v, false);
+		buildEnemyPrefab(m_smallEnemyPrefabs[v], v, true);
+	}
+}
+
+void Game::buildEnemyPrefab(Prefab& p, size_t points, bool small)
+{
+	// small enemies are half the size, worth double and don't last
+	const EnemyConfig& e = m_enemyConfig;
+	float scale = small ? 0.5f : 1.0f;
+	p.tag = small ? "smallEnemy" : "enemy";
+	p.transform.emplace(Vec2(0, 0), Vec2(0, 0), 0.0f);
+	p.shape.emplace(e.SR * scale, static_cast<int>(points), sf::Color::White, sf::Color(e.OR, e.OG, e.OB), e.OT);
+	p.collision.emplace(e.CR * scale);
+	p.score.emplace(small ? 200 : 100);
+	if (small)
+	{
+		p.lifespan.emplace(e.L - 50);
+	}
+}
+
+const Prefab& Game::enemyPrefab(size_t points, bool small) const
+{
+	return small ? m_smallEnemyPrefabs[points] : m_enemyPrefabs[points];
+}
+
+std::shared_ptr<Entity> Game::addEntity(const std::string& tag)
+{
+	auto entity = m_entities.addEntity(tag);
+	m_events.spawned.push({ entity->id(), tag });
+	return entity;
+}
+
+// respawn the player in the middle of the screen
+void Game::spawnPlayer()
+{
+	// We create every entity by calling EntityManager.addEntity(tag)
+	// This returns a std::shared_ptr<Entity>, so we use 'auto' to save typing
+	auto entity = addEntity("player");
+
+	// Give this entity a Transform so it spawns at (200, 200) with velocity (1, 1) and angle 0
+	// Spawn at the middle of window
+	float mx = m_worldSize.x / 2.0f;
+	float my = m_worldSize.y / 2.0f;
+
+	entity->cTransform = std::make_shared<CTransform>(Vec2(mx, my), Vec2(m_playerConfig.S, m_playerConfig.S), 0.0f);
+	entity->cShape = std::make_shared<CShape>(m_playerConfig.SR, m_playerConfig.V,
+		sf::Color(m_playerConfig.FR, m_playerConfig.FG, m_playerConfig.FB),
+		sf::Color(m_playerConfig.OR, m_playerConfig.OG, m_playerConfig.OB), m_playerConfig.OT);
+	entity->cCollision = std::make_shared<CCollision>(m_playerConfig.CR);
+
+	// Add an input component to the player so that we can use inputs
+	entity->cInput = std::make_shared<CInput>();
+
+	// Since we want this Entity to be our player, set our Game's player variable to be this Entity
+	// This goes slightly against the EntityManager paradigm, but we use the player so much it's worth it
+	m_player = entity;
+
+}
+
+// spawn a bot controlled player somewhere random, bot carries its strategy and state across respawns
+void Game::spawnBot(std::shared_ptr<CBot> bot)
+{
+	auto entity = addEntity("player");
+
+	std::uniform_real_distribution<float> x(m_playerConfig.CR, m_worldSize.x - m_playerConfig.CR);
+	std::uniform_real_distribution<float> y(m_playerConfig.CR, m_worldSize.y - m_playerConfig.CR);
+	Vec2 pos(x(bot->rng), y(bot->rng));
+
+	// same as the player but in cool colours so the human one stands out
+	entity->cTransform = std::make_shared<CTransform>(pos, Vec2(0, 0), 0.0f);
+	entity->cShape = std::make_shared<CShape>(m_playerConfig.SR, m_playerConfig.V,
+		sf::Color(m_playerConfig.FB, m_playerConfig.FR, m_playerConfig.FG),
+		sf::Color(m_playerConfig.OB, m_playerConfig.OR, m_playerConfig.OG), m_playerConfig.OT);
+	entity->cCollision = std::make_shared<CCollision>(m_playerConfig.CR);
+	entity->cInput = std::make_shared<CInput>();
+	entity->cBot = bot;
+}
+
+// spawn an enemy at a random position
+void Game::spawnEnemy()
+{
+	// spawn at random position
+	std::uniform_int_distribution<unsigned> x(0, m_worldSize.x - 1);
+	std::uniform_int_distribution<unsigned> y(0, m_worldSize.y - 1);
+	float ex = static_cast<float>(x(m_rng));
+	float ey = static_cast<float>(y(m_rng));
+
+	spawnEnemy(Vec2(ex, ey));
+}
+
+// spawn an enemy at the given position
+void Game::spawnEnemy(const Vec2& pos)
+{
+	// Randomize enemy shape vertices
+	std::uniform_int_distribution<int> vertices(m_enemyConfig.VMIN, m_enemyConfig.VMAX);
+	int eV = vertices(m_rng);
+
+	// Randomize enemy speed between SMIN & SMAX
+	std::uniform_real_distribution<float> speed(m_enemyConfig.SMIN, m_enemyConfig.SMAX);
+	float eS = speed(m_rng);
+
+	// Randomize enemy shape color
+	std::uniform_int_distribution<int> color(0, 255);
+	int eShapeColR = color(m_rng);
+	int eShapeColG = color(m_rng);
+	int eShapeColB = color(m_rng);
+
+	// everything else comes from the prefab for that many vertices
+	spawnBatch(enemyPrefab(eV, false), 1, [&](Entity& e, size_t)
+	{
+		e.cTransform->pos = pos;
+		e.cTransform->velocity = Vec2(eS, eS);
+		e.cShape->circle.setFillColor(sf::Color(eShapeColR, eShapeColG, eShapeColB));
+	});
+
+	// record when the most recent enemy was spawned
+	m_lastEnemySpawnTime = m_currentFrame;
+}
+
+// spawn the small enemies when a big one (input entity e) explodes
+void Game::spawnSmallEnemies(const Entity& parent)
+{
+	// when we create the smaller enemy, we have to read the values of the original enemy
+	// - spawn a number of small enemies equal to the vertices of the original enemy
+	// - set each small enemy to the same color as the original, half the size
+	// - small enemies are worth double points of the original enemy
+
+	// Get the number of vertices of the original enemy
+	size_t vertices = parent.cShape->points;
+
+	// Get the position and velocity of the parent enemy
+	Vec2 parentPos = parent.cTransform->pos;
+	Vec2 parentVelocity = parent.cTransform->velocity;
+
+	// the prefab has the size, lifespan and outline, the fill is the parent's random colour
+	sf::Color parentFill = parent.cShape->circle.getFillColor();
+	sf::Color parentOutline = parent.cShape->circle.getOutlineColor();
+	int score = parent.cScore->score * 2;
+
+	// all of them in one batch, spread evenly around the circle
+	spawnBatch(enemyPrefab(vertices, true), vertices, [&](Entity& e, size_t i)
+	{
+		double radians{ i * 2.0 * std::numbers::pi / vertices };
+
+		e.cTransform->pos = parentPos;
+		e.cTransform->velocity = Vec2(std::cos(radians) * parentVelocity.x, std::sin(radians) * parentVelocity.y);
+		e.cShape->circle.setFillColor(parentFill);
+		e.cShape->circle.setOutlineColor(parentOutline);
+		e.cScore->score = score;
+	});
+}
+
+// burst of debris in the entity's colours, sized by how big it was
+void Game::spawnExplosion(const Entity& entity)
+{
+	// already shown the first time the tick ran
+	if (m_resimulating)
+	{
+		return;
+	}
+
+	float radius = entity.cShape->circle.getRadius();
+	size_t count = static_cast<size_t>(radius * 1.5f);
+
+	m_particles.emit(entity.cTransform->pos, count, 5.0f, 45, entity.cShape->circle.getFillColor());
+	m_particles.emit(entity.cTransform->pos, count / 2, 3.0f, 30, entity.cShape->circle.getOutlineColor());
+}
+
+// spawn a bullet from a given entity to a target location
+void Game::spawnBullet(std::shared_ptr<Entity> entity, const Vec2& target)
+{
+	// Implement the spawning of a bullet which travels towards target
+	//		 - bullet speed is given as a scalar speed
+	//		 - you must set the velocity by using formula in notes
+
+	// Calculate velocity vector for the bullet
+	Vec2 difference{ target.x - entity->cTransform->pos.x, target.y - entity->cTransform->pos.y };
+	difference.normalize();
+	Vec2 velocity{ m_bulletConfig.S * difference.x, m_bulletConfig.S * difference.y };
+
+	spawnBatch(m_bulletPrefab, 1, [&](Entity& bullet, size_t)
+	{
+		bullet.cTransform->pos = entity->cTransform->pos;
+		bullet.cTransform->velocity = velocity;
+	});
+}
+
+void Game::spawnSpecialWeapon(std::shared_ptr<Entity> entity)
+{
+	const int shots = 15;
+
+	// the whole volley in one batch, evenly spread around the player
+	spawnBatch(m_specialPrefab, shots, [&](Entity& ulti, size_t i)
+	{
+		double radians{ i * 2.0 * std::numbers::pi / shots };
+
+		ulti.cTransform->pos = entity->cTransform->pos;
+		ulti.cTransform->velocity = Vec2(std::cos(radians) * m_bulletConfig.S, std::sin(radians) * m_bulletConfig.S);
+	});
+}
+
+void Game::sFlowField()
+{
+	if (!m_chaseConfig.ON)
+	{
+		return;
+	}
+
+	// one field per frame shared by every chasing enemy
+	m_flowField.update(m_player->cTransform->pos);
+}
+
+void Game::sBots()
+{
+	// one batched nearest enemy query for all the bots
+	std::vector<std::shared_ptr<Entity>> bots;
+	std::vector<Vec2> positions;
+	for (auto& e : m_entities.getEntities("player"))
+	{
+		if (e->cBot && e->isActive())
+		{
+			bots.push_back(e);
+			positions.push_back(e->cTransform->pos);
+		}
+	}
+
+	if (bots.empty())
+	{
+		return;
+	}
+
+	std::vector<Entity*> nearest;
+	m_enemyIndex.nearest(positions, nearest, std::numeric_limits<float>::max());
+
+	Vec2 worldSize(static_cast<float>(m_worldSize.x), static_cast<float>(m_worldSize.y));
+
+	for (size_t i = 0; i < bots.size(); ++i)
+	{
+		auto& e = bots[i];
+		CBot& bot = *e->cBot;
+
+		BotView view;
+		view.pos = e->cTransform->pos;
+		view.nearestEnemy = nearest[i] && nearest[i]->isActive() ? nearest[i] : nullptr;
+		view.worldSize = worldSize;
+		view.frame = m_currentFrame + bot.index;
+
+		BotAction action;
+		bot.strategy->think(view, bot.rng, bot.heading, action);
+		applyAction(e, action);
+	}
+}
+
+void Game::applyAction(std::shared_ptr<Entity> player, const BotAction& action)
+{
+	player->cInput->up = action.up;
+	player->cInput->down = action.down;
+	player->cInput->left = action.left;
+	player->cInput->right = action.right;
+	player->cInput->shoot = action.fire;
+
+	if (action.fire)
+	{
+		spawnBullet(player, action.target);
+	}
+	if (action.special)
+	{
+		spawnSpecialWeapon(player);
+	}
+}
+
+void Game::sParticles()
+{
+	m_particles.update();
+}
+
+void Game::sMovement()
+{
+	for (auto& e : m_entities.getEntities())
+	{
+		if (e->tag() == "player")
+		{
+			movePlayer(*e);
+		}
+		else if (e->cTransform)
+		{
+			moveEntity(*e);
+		}
+	}
+}
+
+void Game::movePlayer(Entity& e)
+{
+	// implement player movement, bots fill in the same input component as the keyboard
+	e.cTransform->velocity = { 0,0 };
+
+	if (e.cInput->up) // W key
+	{
+		e.cTransform->velocity.y -= m_playerConfig.S;
+	}
+
+	if (e.cInput->down) // S key
+	{
+		e.cTransform->velocity.y += m_playerConfig.S;
+	}
+
+	if (e.cInput->left) // A key
+	{
+		e.cTransform->velocity.x -= m_playerConfig.S;
+	}
+
+	if (e.cInput->right) // D key
+	{
+		e.cTransform->velocity.x += m_playerConfig.S;
+	}
+
+	// update position of the player
+	e.cTransform->pos.x += e.cTransform->velocity.x;
+	e.cTransform->pos.y += e.cTransform->velocity.y;
+
+	// rotates the player
+	e.cTransform->angle += 2.0f;
+	e.cShape->circle.setRotation(e.cTransform->angle);
+}
+
+void Game::moveEntity(Entity& e)
+{
+	// entities far from the camera move every FT ticks by FT ticks worth, spread over the ticks by id
+	int step = 1;
+	if (m_worldConfig.FD > 0 && m_worldConfig.FT > 1)
+	{
+		Vec2 camera(m_camera.getCenter().x, m_camera.getCenter().y);
+		float farDistance = static_cast<float>(m_worldConfig.FD);
+		Vec2 d = e.cTransform->pos - camera;
+		if (d.x * d.x + d.y * d.y > farDistance * farDistance)
+		{
+			if ((m_currentFrame + e.id()) % m_worldConfig.FT != 0)
+			{
+				return;
+			}
+			step = m_worldConfig.FT;
+		}
+	}
+
+	// chasing enemies keep their speed but take their heading from the flow field
+	if (m_chaseConfig.ON && (e.tag() == "enemy" || e.tag() == "smallEnemy"))
+	{
+		Vec2 dir = m_flowField.sample(e.cTransform->pos);
+		float speed = e.cTransform->velocity.dist(Vec2(0, 0));
+		if (dir.x != 0 || dir.y != 0)
+		{
+			e.cTransform->velocity = dir * speed;
+		}
+	}
+
+	// update the position of entities
+	e.cTransform->pos += e.cTransform->velocity * static_cast<float>(step);
+
+	// rotates the entity
+	e.cTransform->angle += 2.0f;
+	e.cShape->circle.setRotation(e.cTransform->angle);
+}
+
+void Game::sRender()
+{
+	m_window.clear();
+
+	// the background scrolls itself, so it and the score are drawn in window pixels
+	m_window.setView(m_hudView);
+	m_background.scroll(m_camera.getCenter(), m_currentFrame);
+	m_window.draw(m_background);
+
+	m_window.setView(m_camera);
+
+	// only entities overlapping the camera get sent to the gpu
+	sf::Vector2f viewMin = m_camera.getCenter() - m_camera.getSize() / 2.0f;
+	sf::Vector2f viewMax = m_camera.getCenter() + m_camera.getSize() / 2.0f;
+
+	int quality = m_governor.level();
+
+	// shapes out toward the edges of the view count as far, the eye is on the middle
+	float farDistance = std::min(m_camera.getSize().x, m_camera.getSize().y) / 2.0f;
+
+	for (auto e : m_entities.getEntities())
+	{
+		const Vec2& pos = e->cTransform->pos;
+		float reach = e->cShape->circle.getRadius() + e->cShape->outline;
+		if (pos.x + reach < viewMin.x || pos.x - reach > viewMax.x || pos.y + reach < viewMin.y || pos.y - reach > viewMax.y)
+		{
+			continue;
+		}
+
+		// new shapes, shapes made before the last quality change and ones that moved
+		// between the middle and the edges need setting up
+		sf::Vector2f d(pos.x - m_camera.getCenter().x, pos.y - m_camera.getCenter().y);
+		bool far = d.x * d.x + d.y * d.y > farDistance * farDistance;
+		if (e->cShape->lod != quality * 2 + far)
+		{
+			applyShapeQuality(*e, quality, far);
+		}
+
+		// set the position of the shape based on the entity's transform->pos
+		e->cShape->circle.setPosition(e->cTransform->pos.x, e->cTransform->pos.y);
+
+		// set the rotation of the shape based on the entity's transform->angle
+		e->cTransform->angle += 2.0f;
+		e->cShape->circle.setRotation(e->cTransform->angle);
+
+		m_window.draw(e->cShape->circle);
+	}
+
+	// every particle in one draw call
+	m_window.draw(m_particles);
+
+	m_window.setView(m_hudView);
+	m_window.draw(m_text);
+
+	// the time spent in display() is mostly the frame limiter sleeping, so leave it out
+	float workMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - m_frameStart).count();
+
+	m_window.display();
+
+	// the level is reported through the quality_level metric
+	if (m_governorOn && m_governor.update(workMs))
+	{
+		setQuality(m_governor.level());
+	}
+
+	// everything applied before this display() is now on screen
+	auto presented = InputClock::now();
+	for (auto& t : m_presentPending)
+	{
+		m_inputToPresent.record(std::chrono::duration_cast<std::chrono::microseconds>(presented - t).count());
+	}
+	m_presentPending.clear();
+}
+
+// per governor level: point cap for small round shapes (0 = no cap), share of
+// the particle capacity allowed, and how much the spawn interval is stretched
+static const size_t QualityPointCap[FrameGovernor::MaxLevel + 1] = { 0, 0, 12, 8, 6 };
+static const float QualityParticles[FrameGovernor::MaxLevel + 1] = { 1.0f, 1.0f, 0.5f, 0.25f, 0.1f };
+static const int QualitySpawnScale[FrameGovernor::MaxLevel + 1] = { 1, 1, 1, 2, 4 };
+
+// shapes at or below this radius count as small
+static const float SmallShapeRadius = 24.0f;
+
+// shapes with more points than this are drawn as circles rather than polygons
+static const size_t RoundShapePoints = 12;
+
+void Game::setQuality(int level)
+{
+	m_particles.setLimit(static_cast<size_t>(m_particles.capacity() * QualityParticles[level]));
+	m_spawnIntervalScale = QualitySpawnScale[level];
+}
+
+void Game::applyShapeQuality(Entity& entity, int level, bool far)
+{
+	CShape& shape = *entity.cShape;
+	shape.lod = level * 2 + far;
+
+	// small round shapes (bullets mostly) look the same with far fewer points, and so
+	// do big round ones out at the edges. Big polygons keep their corners since the
+	// point count is what they look like
+	size_t points = shape.points;
+	size_t cap = QualityPointCap[level];
+	bool small = shape.circle.getRadius() <= SmallShapeRadius;
+	bool round = points > RoundShapePoints;
+	if (cap > 0 && (small || (far && round)) && points > cap)
+	{
+		points = cap;
+	}
+	if (points != shape.circle.getPointCount())
+	{
+		shape.circle.setPointCount(points);
+	}
+
+	// from level 1 only the player keeps an outline
+	float outline = (level >= 1 && entity.tag() != "player") ? 0.0f : shape.outline;
+	if (outline != shape.circle.getOutlineThickness())
+	{
+		shape.circle.setOutlineThickness(outline);
+	}
+}
+
+void Game::sLifespan()
+{
+	for (auto e : m_entities.getEntities())
+	{
+		if (e->cLifespan)
+		{
+			ageEntity(*e);
+		}
+	}
+}
+
+void Game::ageEntity(Entity& e)
+{
+	//		if entity has > 0 remaining lifespan, subtract 1
+	//		if it has lifespan and is alive
+	//			scale its alpha channel properly
+	//		if it has lifespan and its time is up
+	//			destroy the entity
+	if (e.cLifespan->remaining > 0)
+	{
+		e.cLifespan->remaining--;
+	}
+
+	if (e.isActive() && e.cLifespan->remaining > 0)
+	{
+		float alphaMultiplier{ static_cast<float>(e.cLifespan->remaining) / static_cast<float>(e.cLifespan->total) };
+
+		auto fillColor{ e.cShape->circle.getFillColor() };
+		sf::Color newFillColor{ fillColor.r,fillColor.g,fillColor.b, static_cast<sf::Uint8>(255 * alphaMultiplier) };
+		e.cShape->circle.setFillColor(newFillColor);
+
+		auto outlineColor{ e.cShape->circle.getOutlineColor() };
+		sf::Color newOutlineColor{ outlineColor.r,outlineColor.g,outlineColor.b, static_cast<sf::Uint8>(255 * alphaMultiplier) };
+		e.cShape->circle.setOutlineColor(newOutlineColor);
+
+	}
+	else if (e.cLifespan->remaining <= 0)
+	{
+		e.destroy();
+	}
+}
+
+static bool touching(const Entity& a, const Entity& b)
+{
+	Vec2 diff{ b.cTransform->pos.x - a.cTransform->pos.x , b.cTransform->pos.y - a.cTransform->pos.y };
+	double collisionRadiusSQ{ (a.cCollision->radius + b.cCollision->radius) * (a.cCollision->radius + b.cCollision->radius) };
+	double distSQ{ (diff.x * diff.x) + (diff.y * diff.y) };
+	return distSQ < collisionRadiusSQ;
+}
+
+// a bullet only takes out one enemy, big enemies first and the oldest one of them
+static Entity* bulletTarget(std::span<Entity* const> hits)
+{
+	Entity* target = nullptr;
+	for (auto enemy : hits)
+	{
+		if (!enemy->isActive())
+		{
+			continue;
+		}
+
+		bool better = !target
+			|| (enemy->tag() == "enemy" && target->tag() != "enemy")
+			|| (enemy->tag() == target->tag() && enemy->id() < target->id());
+		if (better)
+		{
+			target = enemy;
+		}
+	}
+	return target;
+}
+
+void Game::sCollision()
+{
+	//		(use m_currentFrame - m_lastEnemySpawnTime) to determine
+	//		how long it has been since the last enemy spawned
+
+	for (auto player : m_entities.getEntities("player"))
+	{
+		// Skip if player is not active
+		if (!player->isActive())
+			continue;
+
+		// Case 1: collision between player and enemy
+		// destroy player, destroy enemy, respawn player
+		for (auto enemy : m_entities.getEntities("enemy"))
+		{
+			//makes sure the player is alive and doesnt spawn 2 players, and the enemy hasn't already hit another one
+			if (touching(*player, *enemy) && player->isActive() && enemy->isActive())
+			{
+				playerHit(player, *enemy);
+			}
+		}
+
+		// Case 2: collision between player and small enemy
+		// destroy player, destroy enemy, respawn player
+		for (auto enemy : m_entities.getEntities("smallEnemy"))
+		{
+			if (touching(*player, *enemy) && player->isActive() && enemy->isActive())
+			{
+				playerHit(player, *enemy);
+			}
+		}
+	}
+
+	// Case 3: collision between bullet and enemy
+	// destroy the bullet, destroy the enemy, spawn small enemy
+	// Case 4: collision between bullet and small enemy
+	// destroy the bullet, destroy the small enemy
+	std::vector<Entity*> hits;
+	for (auto bullet : m_entities.getEntities("bullet"))
+	{
+		hits.clear();
+		m_enemyIndex.radius(bullet->cTransform->pos, bullet->cCollision->radius, hits);
+
+		if (Entity* target = bulletTarget(hits))
+		{
+			bulletHit(*bullet, *target);
+		}
+	}
+
+	//General Collision ie walls && ground && ceiling for player
+	for (auto e : m_entities.getEntities("player"))
+	{
+		keepInWorld(*e);
+	}
+
+	//General Collision ie walls && ground && ceiling for entities
+	for (auto e : m_entities.getEntities())
+	{
+		if (e->tag() == "enemy")
+		{
+			bounceOffWalls(*e);
+		}
+	}
+}
 
-		//Calculate the velocity
-		double radians{ angle * std::numbers::pi / 180.0 };
+void Game::playerHit(const std::shared_ptr<Entity>& player, Entity& enemy)
+{
+	bool small = enemy.tag() == "smallEnemy";
 
-		// Calculate x and y components of velocity
-		float velX = std::cos(radians);
-		float velY = std::sin(radians);
+	spawnExplosion(enemy);
+	spawnExplosion(*player);
+	enemy.destroy();
+	player->destroy();
 
-		// Set the velocity of the small enemy
-		Vec2 newVelocity{ velX * parent->cTransform->velocity.x, velY * parent->cTransform->velocity.y };
+	m_events.playerHit.push({ player->id(), player->cBot != nullptr, small, player->cTransform->pos });
 
-		// Spawn the small enemy with calculated properties
-		smallEnemy->cTransform = std::make_shared<CTransform>(parentPos, newVelocity, 0);
+	// bots come back on their own and don't cost the human any score
+	if (player->cBot)
+	{
+		spawnBot(player->cBot);
+		return;
+	}
 
-		// Update the angle for the next small enemy
-		angle += 360.0f / vertices;
+	// a small enemy only takes half
+	if (small)
+	{
+		m_score /= 2;
+	}
+	else
+	{
+		m_score = 0;
 	}
+	spawnPlayer();
 }
 
-// spawn a bullet from a given entity to a target location
-void Game::spawnBullet(std::shared_ptr<Entity> entity, const Vec2& target)
+void Game::bulletHit(Entity& bullet, Entity& target)
 {
-	// Implement the spawning of a bullet which travels towards target
-	//		 - bullet speed is given as a scalar speed
-	//		 - you must set the velocity by using formula in notes
-
-	auto bullet = m_entities.addEntity("bullet");
-	bullet->cShape = std::make_shared<CShape>(m_bulletConfig.SR, m_bulletConfig.V, 
-						sf::Color(m_bulletConfig.FR, m_bulletConfig.FG, m_bulletConfig.FB), 
-						sf::Color(m_bulletConfig.OR, m_bulletConfig.OG, m_bulletConfig.OB), m_bulletConfig.OT);
-	bullet->cCollision = std::make_shared<CCollision>(m_bulletConfig.CR);
-	bullet->cLifespan = std::make_shared<CLifespan>(m_bulletConfig.L);
+	//Updates the score, the HUD catches up once at the end of the tick
+	m_score += target.cScore->score;
+	m_events.enemyKilled.push({ target.id(), target.tag() == "smallEnemy", target.cScore->score, target.cTransform->pos });
 
-	// Calculate velocity vector for the bullet
-	Vec2 difference{ target.x - entity->cTransform->pos.x, target.y - entity->cTransform->pos.y };
-	difference.normalize();
-	Vec2 velocity{ m_bulletConfig.S * difference.x, m_bulletConfig.S * difference.y };
+	if (target.tag() == "enemy")
+	{
+		spawnSmallEnemies(target);
+	}
 
-	// Add transform component to the bullet
-	bullet->cTransform = std::make_shared<CTransform>(entity->cTransform->pos, velocity, 0);
+	spawnExplosion(target);
+	bullet.destroy();
+	target.destroy();
 }
 
-void Game::spawnSpecialWeapon(std::shared_ptr<Entity> entity)
+void Game::keepInWorld(Entity& e)
 {
-	float angle{ 0 };
-
-	for (int j{ 0 }; j < 15; ++j)
+	//Checks to see if player collided with walls
+	if (e.cTransform->pos.x + m_playerConfig.CR > m_worldSize.x)
 	{
-		auto ulti = m_entities.addEntity("bullet");
-
-		// my ulti is pink color square shape pillow
-		ulti->cShape = std::make_shared<CShape>(20, 4, sf::Color(255, 160, 122),
-			sf::Color(205, 92, 92), m_bulletConfig.OT);
-
-		// TODO: implement collision and lifespan
-		ulti->cCollision = std::make_shared<CCollision>(m_bulletConfig.CR);
-		ulti->cLifespan = std::make_shared<CLifespan>(m_bulletConfig.L);
-
-		Vec2 normalizedPos{ Vec2::normalize(m_player->cTransform->pos) };
-
-		//Calculate the velocity
-		double radians{ angle * std::numbers::pi / 180.0 };
-
-		// Calculate x and y components of velocity
-		float velX = std::cos(radians);
-		float velY = std::sin(radians);
-
-		//Scales the normalized vertor by the parents velocity
-		Vec2 newVelocity{ velX * m_bulletConfig.S, velY * m_bulletConfig.S };
-
-		ulti->cTransform = std::make_shared<CTransform>(m_player->cTransform->pos, newVelocity, 0);
+		e.cTransform->pos.x -= m_playerConfig.S;
+	}
+	else if (e.cTransform->pos.x - m_playerConfig.CR < 0)
+	{
+		e.cTransform->pos.x += m_playerConfig.S;
+	}
 
-		angle += 360.0f / 15.0f;
+	if (e.cTransform->pos.y + m_playerConfig.CR > m_worldSize.y)
+	{
+		e.cTransform->pos.y -= m_playerConfig.S;
+	}
+	else if (e.cTransform->pos.y - m_playerConfig.CR < 0)
+	{
+		e.cTransform->pos.y += m_playerConfig.S;
 	}
 }
 
-void Game::sMovement()
+void Game::bounceOffWalls(Entity& e)
 {
-	m_player->cTransform->velocity = { 0,0 };
-
-	// implement player movement
-	if (m_player->cInput->up) // W key
+	// point the velocity back inside rather than flipping it, an enemy that is still
+	// outside next tick (far ones only move every few ticks) would flip straight back out
+	if (e.cTransform->pos.x + e.cCollision->radius > m_worldSize.x)
 	{
-		m_player->cTransform->velocity.y -= m_playerConfig.S;
+		e.cTransform->velocity.x = -std::abs(e.cTransform->velocity.x);
 	}
-	
-	if (m_player->cInput->down) // S key
+	else if (e.cTransform->pos.x - e.cCollision->radius < 0)
 	{
-		m_player->cTransform->velocity.y += m_playerConfig.S;
+		e.cTransform->velocity.x = std::abs(e.cTransform->velocity.x);
 	}
-
-	if (m_player->cInput->left) // A key
+	if (e.cTransform->pos.y + e.cCollision->radius > m_worldSize.y)
 	{
-		m_player->cTransform->velocity.x -= m_playerConfig.S;
+		e.cTransform->velocity.y = -std::abs(e.cTransform->velocity.y);
 	}
-
-	if (m_player->cInput->right) // D key
+	else if (e.cTransform->pos.y - e.cCollision->radius < 0)
 	{
-		m_player->cTransform->velocity.x += m_playerConfig.S;
+		e.cTransform->velocity.y = std::abs(e.cTransform->velocity.y);
 	}
+}
 
-	for (auto e : m_entities.getEntities())
+void Game::sRegions()
+{
+	// the regions take over everything but the players, which need their input
+	m_regions.sync(m_entities.getEntities(), [](const Entity& e) { return e.cTransform && e.tag() != "player"; });
+
+	for (auto& player : m_entities.getEntities("player"))
 	{
-		if (e->tag() == "player")
-		{
-			// update position of the player
-			m_player->cTransform->pos.x += m_player->cTransform->velocity.x;
-			m_player->cTransform->pos.y += m_player->cTransform->velocity.y;
+		movePlayer(*player);
+	}
 
-			// rotates the player
-			e->cTransform->angle += 2.0f;
-			e->cShape->circle.setRotation(e->cTransform->angle);
-		}
-		else if (e->cTransform)
+	// lifespan then movement per entity is the same as all the lifespans then all the movement,
+	// neither looks at any other entity
+	m_regions.update([this](Entity& e)
+	{
+		if (e.cLifespan)
 		{
-			// update the position of entities
-			e->cTransform->pos += e->cTransform->velocity;
-
-			// rotates the entity
-			e->cTransform->angle += 2.0f;
-			e->cShape->circle.setRotation(e->cTransform->angle);
+			ageEntity(e);
 		}
-	}
+		moveEntity(e);
+	});
 }
 
-void Game::sRender()
+void Game::sRegionCollision()
 {
-	m_window.clear();
+	const EntityVec& players = m_entities.getEntities("player");
+	m_regionHits.resize(m_regions.size());
 
-	m_window.draw(m_backgroundSprite);
+	// every region finds what its own entities touch without changing anything, a bullet
+	// near a border finds enemies in the next region through the shared index
+	m_regions.forEach([&](size_t i, WorldRegions::Region& region)
+	{
+		RegionHits& out = m_regionHits[i];
+		out.players.clear();
+		out.bullets.clear();
+		out.targets.clear();
 
-	for (auto e : m_entities.getEntities())
+		for (auto& e : region.entities)
+		{
+			if (e->tag() == "bullet")
+			{
+				size_t begin = out.targets.size();
+				m_enemyIndex.radius(e->cTransform->pos, e->cCollision->radius, out.targets);
+				if (out.targets.size() > begin)
+				{
+					out.bullets.push_back({ e.get(), i, begin, out.targets.size() });
+				}
+			}
+			else if (e->tag() == "enemy" || e->tag() == "smallEnemy")
+			{
+				for (size_t p = 0; p < players.size(); ++p)
+				{
+					if (touching(*players[p], *e))
+					{
+						out.players.push_back({ p, e.get() });
+					}
+				}
+			}
+		}
+	});
+
+	// then it is all settled here, in the order sCollision goes in (players, then bullets
+	// oldest first), so the outcome doesn't depend on how the world is cut up. An enemy that
+	// already hit an earlier player is gone, the next oldest one touching is taken instead
+	for (size_t p = 0; p < players.size(); ++p)
 	{
-		// set the position of the shape based on the entity's transform->pos
-		e->cShape->circle.setPosition(e->cTransform->pos.x, e->cTransform->pos.y);
+		for (bool small : { false, true })
+		{
+			Entity* oldest = nullptr;
+			for (auto& hits : m_regionHits)
+			{
+				for (auto& hit : hits.players)
+				{
+					Entity* e = hit.enemy;
+					if (hit.player == p && (e->tag() == "smallEnemy") == small && e->isActive() && (!oldest || e->id() < oldest->id()))
+					{
+						oldest = e;
+					}
+				}
+			}
+			if (oldest && players[p]->isActive())
+			{
+				playerHit(players[p], *oldest);
+			}
+		}
+	}
 
-		// set the rotation of the shape based on the entity's transform->angle
-		e->cTransform->angle += 2.0f;
-		e->cShape->circle.setRotation(e->cTransform->angle);
+	m_bulletOrder.clear();
+	for (auto& hits : m_regionHits)
+	{
+		for (auto& b : hits.bullets)
+		{
+			m_bulletOrder.push_back(&b);
+		}
+	}
+	std::sort(m_bulletOrder.begin(), m_bulletOrder.end(), [](auto a, auto b) { return a->bullet->id() < b->bullet->id(); });
 
-		m_window.draw(e->cShape->circle);
+	for (auto b : m_bulletOrder)
+	{
+		const std::vector<Entity*>& targets = m_regionHits[b->region].targets;
+		if (Entity* target = bulletTarget(std::span(targets.data() + b->begin, b->end - b->begin)))
+		{
+			bulletHit(*b->bullet, *target);
+		}
 	}
 
-	m_window.draw(m_text);
-	m_window.display();
+	for (auto& player : players)
+	{
+		keepInWorld(*player);
+	}
+
+	m_regions.forEach([this](size_t, WorldRegions::Region& region)
+	{
+		for (auto& e : region.entities)
+		{
+			if (e->tag() == "enemy")
+			{
+				bounceOffWalls(*e);
+			}
+		}
+	});
 }
 
-void Game::sLifespan()
+void Game::sSpatialIndex()
 {
-	// for all entities
-	//		if entity has no lifespan component, skip it
-	//		if entity has > 0 remaining lifespan, subtract 1
-	//		if it has lifespan and is alive
-	//			scale its alpha channel properly
-	//		if it has lifespan and its time is up
-	//			destroy the entity
+	m_enemyIndex.clear();
+	m_enemyIndex.add(m_entities.getEntities("enemy"));
+	m_enemyIndex.add(m_entities.getEntities("smallEnemy"));
+	m_enemyIndex.build();
+}
 
-	for (auto e : m_entities.getEntities())
+void Game::sHoming()
+{
+	// one batched nearest-enemy query for every homing projectile
+	std::vector<std::shared_ptr<Entity>> homing;
+	std::vector<Vec2> positions;
+	float range = 0;
+	for (auto& e : m_entities.getEntities("bullet"))
 	{
-		if (!e->cLifespan)
+		if (e->cHoming && e->isActive())
 		{
-			continue;
+			homing.push_back(e);
+			positions.push_back(e->cTransform->pos);
+			range = std::max(range, e->cHoming->range);
 		}
+	}
+
+	if (homing.empty())
+	{
+		return;
+	}
 
-		if (e->cLifespan->remaining > 0)
+	std::vector<Entity*> targets;
+	// the search stops at the longest range, and skips enemies killed since the index was built
+	m_enemyIndex.nearest(positions, targets, range);
+
+	for (size_t i = 0; i < homing.size(); ++i)
+	{
+		auto& e = homing[i];
+		Entity* target = targets[i];
+		if (!target)
 		{
-			e->cLifespan->remaining--;
+			continue;
 		}
 
-		if (e->isActive() && e->cLifespan->remaining > 0)
+		Vec2 toTarget = target->cTransform->pos - e->cTransform->pos;
+		float dist = toTarget.dist(Vec2(0, 0));
+		float speed = e->cTransform->velocity.dist(Vec2(0, 0));
+		if (dist == 0 || speed == 0 || dist > e->cHoming->range)
 		{
-			float alphaMultiplier{ static_cast<float>(e->cLifespan->remaining) / static_cast<float>(e->cLifespan->total) };
-
-			auto fillColor{ e->cShape->circle.getFillColor() };
-			sf::Color newFillColor{ fillColor.r,fillColor.g,fillColor.b, static_cast<sf::Uint8>(255 * alphaMultiplier) };
-			e->cShape->circle.setFillColor(newFillColor);
-
-			auto outlineColor{ e->cShape->circle.getOutlineColor() };
-			sf::Color newOutlineColor{ outlineColor.r,outlineColor.g,outlineColor.b, static_cast<sf::Uint8>(255 * alphaMultiplier) };
-			e->cShape->circle.setOutlineColor(newOutlineColor);
-
+			continue;
 		}
-		else if (e->cLifespan->remaining <= 0)
+
+		// turn part of the way toward the target, keeping the projectile's speed
+		Vec2 desired = toTarget * (speed / dist);
+		Vec2 velocity = e->cTransform->velocity + (desired - e->cTransform->velocity) * e->cHoming->turnRate;
+		float length = velocity.dist(Vec2(0, 0));
+		if (length > 0)
 		{
-			e->destroy();
+			e->cTransform->velocity = velocity * (speed / length);
 		}
 	}
 }
 
-void Game::sCollision()
+void Game::sEvents()
 {
-	//		(use m_currentFrame - m_lastEnemySpawnTime) to determine
-	//		how long it has been since the last enemy spawned
-
-	// Case 1: collision between player and enemy
-	// destroy player, destroy enemy, respawn player
-	for (auto player : m_entities.getEntities("player"))
+	// subscribers saw this tick the first time round, a replay would count it twice
+	if (m_resimulating)
 	{
-		// Skip if player is not active
-		if (!player->isActive())
-			continue;
+		m_events.clear();
+		return;
+	}
 
-		for (auto enemy : m_entities.getEntities("enemy"))
-		{
-			Vec2 diff{ enemy->cTransform->pos.x - player->cTransform->pos.x , enemy->cTransform->pos.y - player->cTransform->pos.y };
-			double collisionRadiusSQ{ (player->cCollision->radius + enemy->cCollision->radius) * (player->cCollision->radius + enemy->cCollision->radius) };
-			double distSQ{ (diff.x * diff.x) + (diff.y * diff.y) };
+	m_events.dispatch();
 
-			if (distSQ < collisionRadiusSQ)
-			{
-				//makes sure the player is alive and doesnt spawn 2 players
-				if (player->isActive())
-				{
-					m_score = 0;
-					m_text.setString("Score: " + std::to_string(m_score));
-					std::cout << "m_score = " << m_score << "\n";
+	// rebuilding the text lays the glyphs out again, so only when the score really changed
+	if (m_score != m_hudScore)
+	{
+		m_hudScore = m_score;
+		m_text.setString("Score: " + std::to_string(m_score));
+	}
+}
 
-					enemy->destroy();
-					player->destroy();
-					spawnPlayer();
-				}
-			}
-		}
+void Game::sCamera()
+{
+	// centre on the player, but stop at the edges of the world instead of showing past them
+	sf::Vector2f half = m_camera.getSize() / 2.0f;
+	sf::Vector2f world(static_cast<float>(m_worldSize.x), static_cast<float>(m_worldSize.y));
+	const Vec2& pos = m_player->cTransform->pos;
+
+	float x = world.x > half.x * 2 ? std::clamp(pos.x, half.x, world.x - half.x) : world.x / 2;
+	float y = world.y > half.y * 2 ? std::clamp(pos.y, half.y, world.y - half.y) : world.y / 2;
+	m_camera.setCenter(x, y);
+}
 
-		// Case 2: collision between player and small enemy
-		// destroy player, destroy enemy, respawn player
-		for (auto enemy : m_entities.getEntities("smallEnemy"))
-		{
-			Vec2 diff{ enemy->cTransform->pos.x - player->cTransform->pos.x , enemy->cTransform->pos.y - player->cTransform->pos.y };
-			double collisionRadiusSQ{ (player->cCollision->radius + enemy->cCollision->radius) * (player->cCollision->radius + enemy->cCollision->radius) };
-			double distSQ{ (diff.x * diff.x) + (diff.y * diff.y) };
+Vec2 Game::screenToWorld(int x, int y) const
+{
+	// one world unit per pixel, so it's just the camera's top left corner plus the pixel
+	sf::Vector2f corner = m_camera.getCenter() - m_camera.getSize() / 2.0f;
+	return Vec2(corner.x + x, corner.y + y);
+}
 
-			if (distSQ < collisionRadiusSQ)
-			{
-				//makes sure the player is alive so it doesnt spawn 2 players
-				if (player->isActive())
-				{
-					m_score /= 2;
-					m_text.setString("Score: " + std::to_string(m_score));
-					std::cout << "m_score = " << m_score << "\n";
+void Game::sEnemySpawner()
+{
+	// wakes only the scripts that are due this frame
+	m_waves.update(m_currentFrame);
+}
 
-					player->destroy();
-					enemy->destroy();
-					spawnPlayer();
-				}
-			}
-		}
+// one enemy at a random position every SI frames
+WaveScript Game::regularWave()
+{
+	while (true)
+	{
+		co_await m_waves.delay(m_enemyConfig.SI * m_spawnIntervalScale);
+		spawnEnemy();
 	}
+}
 
-	// Case 3: collision between bullet and enemy
-	// destroy the bullet, destroy the enemy, spawn small enemy
-	for (auto bullet : m_entities.getEntities("bullet"))
+// once the screen is clear, close a ring of enemies in around the player one at a time
+WaveScript Game::ringWave()
+{
+	const int ringSize = 12;
+	const float ringRadius = 300.0f;
+
+	while (true)
 	{
-		for (auto enemy : m_entities.getEntities("enemy"))
+		co_await m_waves.until([this]()
 		{
-			Vec2 diff{ enemy->cTransform->pos.x - bullet->cTransform->pos.x , enemy->cTransform->pos.y - bullet->cTransform->pos.y };
-			double collisionRadiusSQ{ (bullet->cCollision->radius + enemy->cCollision->radius) * (bullet->cCollision->radius + enemy->cCollision->radius) };
-			double distSQ{ (diff.x * diff.x) + (diff.y * diff.y) };
-
-			if (distSQ < collisionRadiusSQ)
-			{
-				//Updates the score
-				m_score += enemy->cScore->score;
-				m_text.setString("Score: " + std::to_string(m_score));
-				std::cout << "m_score = " << m_score << "\n";
-
-				spawnSmallEnemies(enemy);
-				bullet->destroy();
-				enemy->destroy();
+			return m_entities.getEntities("enemy").empty() && m_entities.getEntities("smallEnemy").empty();
+		});
 
-				break;
-			}
-		}
+		// give the player a moment before the ring starts
+		co_await m_waves.delay(60);
 
-		// Case 4: collision between bullet and small enemy
-		// destroy the bullet, destroy the small enemy
-		for (auto enemy : m_entities.getEntities("smallEnemy"))
+		Vec2 center = m_player->cTransform->pos;
+		for (int i = 0; i < ringSize; ++i)
 		{
-			Vec2 diff{ enemy->cTransform->pos.x - bullet->cTransform->pos.x , enemy->cTransform->pos.y - bullet->cTransform->pos.y };
-			double collisionRadiusSQ{ (bullet->cCollision->radius + enemy->cCollision->radius) * (bullet->cCollision->radius + enemy->cCollision->radius) };
-			double distSQ{ (diff.x * diff.x) + (diff.y * diff.y) };
+			double radians{ i * 2.0 * std::numbers::pi / ringSize };
+			Vec2 pos = center + Vec2(std::cos(radians) * ringRadius, std::sin(radians) * ringRadius);
 
-			if (distSQ < collisionRadiusSQ)
-			{
-				m_score += enemy->cScore->score;
-				m_text.setString("Score: " + std::to_string(m_score));
-				std::cout << "m_score = " << m_score << "\n";
-
-				bullet->destroy();
-				enemy->destroy();
+			// keep the ring inside the walls, enemies spawned outside would get stuck bouncing
+			float r = m_enemyConfig.CR;
+			pos.x = std::clamp(pos.x, r, m_worldSize.x - r);
+			pos.y = std::clamp(pos.y, r, m_worldSize.y - r);
+			spawnEnemy(pos);
 
-				break;
-			}
+			co_await m_waves.delay(5);
 		}
 	}
+}
 
-	//General Collision ie walls && ground && ceiling for player
-	for (auto e : m_entities.getEntities("player"))
+// the player stands still in the middle and shoots in the scenario's pattern
+WaveScript Game::firingPattern()
+{
+	const int burstSize = 8;
+
+	if (m_scenario.fire == "none" && m_scenario.specialEvery <= 0)
 	{
-		//Checks to see if player collided with walls
-		if (e->cTransform->pos.x + m_playerConfig.CR > m_window.getSize().x)
-		{
-			e->cTransform->pos.x -= m_playerConfig.S;
-		}
-		else if (e->cTransform->pos.x - m_playerConfig.CR < 0)
+		co_return;
+	}
+
+	while (true)
+	{
+		int wait = m_scenario.fire != "none" ? std::max(1, m_scenario.fireEvery) : m_scenario.specialEvery;
+		co_await m_waves.delay(wait);
+
+		// worked out from the tick instead of counted in locals, so rollback can restore this script
+		int tick = m_waves.currentTick();
+		int shot = tick / wait;
+
+		if (!m_player->isActive())
 		{
-			e->cTransform->pos.x += m_playerConfig.S;
+			continue;
 		}
+		Vec2 pos = m_player->cTransform->pos;
 
-		if (e->cTransform->pos.y + m_playerConfig.CR > m_window.getSize().y)
+		if (m_scenario.fire == "aim")
 		{
-			e->cTransform->pos.y -= m_playerConfig.S;
+			// oldest enemy still alive
+			for (auto& e : m_entities.getEntities("enemy"))
+			{
+				if (e->isActive())
+				{
+					spawnBullet(m_player, e->cTransform->pos);
+					break;
+				}
+			}
 		}
-		else if (e->cTransform->pos.y - m_playerConfig.CR < 0)
+		else if (m_scenario.fire == "spiral")
 		{
-			e->cTransform->pos.y += m_playerConfig.S;
+			double radians{ shot * 0.3 };
+			spawnBullet(m_player, pos + Vec2(std::cos(radians) * 100, std::sin(radians) * 100));
 		}
-	}
-
-	//General Collision ie walls && ground && ceiling for entities
-	for (auto e : m_entities.getEntities())
-	{
-		if (e->tag() == "enemy")
+		else if (m_scenario.fire == "burst")
 		{
-			if (e->cTransform->pos.x + e->cCollision->radius > m_window.getSize().x)
-			{
-				e->cTransform->velocity.x *= -1;
-			}
-			else if (e->cTransform->pos.x - e->cCollision->radius < 0)
-			{
-				e->cTransform->velocity.x *= -1;
-			}
-			if (e->cTransform->pos.y + e->cCollision->radius > m_window.getSize().y)
-			{
-				e->cTransform->velocity.y *= -1;
-			}
-			else if (e->cTransform->pos.y - e->cCollision->radius < 0)
+			for (int i = 0; i < burstSize; ++i)
 			{
-				e->cTransform->velocity.y *= -1;
+				double radians{ (i + 0.5 * (shot % 2)) * 2.0 * std::numbers::pi / burstSize };
+				spawnBullet(m_player, pos + Vec2(std::cos(radians) * 100, std::sin(radians) * 100));
 			}
 		}
-	}
-}
 
-void Game::sEnemySpawner()
-{
-	if ((m_currentFrame - m_lastEnemySpawnTime) >= m_enemyConfig.SI)
-	{
-		spawnEnemy();
+		// once per specialEvery ticks, on the first shot at or after each multiple
+		if (m_scenario.specialEvery > 0 && tick / m_scenario.specialEvery != (tick - wait) / m_scenario.specialEvery)
+		{
+			spawnSpecialWeapon(m_player);
+		}
 	}
 }
 
@@ -588,35 +1867,33 @@ void Game::sUserInput()
 	//		 you should not implement the player's movement logic here
 	//		 the movement system will read the variables you set in this function
 
-	sf::Event event;
-	while (m_window.pollEvent(event))
+	// the keys are kept as they change and applied below with this tick's clicks, the same way
+	// a bot's action is, so a rollback can replay them. A resimulated tick doesn't read the queue
+	InputEvent event;
+	while (!m_resimulating && m_input.poll(event))
 	{
-		// this event triggers when the window is closed
-		if (event.type == sf::Event::Closed)
-		{
-			m_running = false;
-		}
+		m_presentPending.push_back(event.time);
 
 		// this event is triggered when a key is pressed
-		if (event.type == sf::Event::KeyPressed)
+		if (event.type == InputEvent::KeyPressed)
 		{
-			switch (event.key.code)
+			switch (event.key)
 			{
 			case sf::Keyboard::W: // Up key
 				std::cout << "W Key Pressed\n";
-				m_player->cInput->up = true;
+				m_localInput.up = true;
 				break;
 			case sf::Keyboard::A: // Left key
 				std::cout << "A Key Pressed\n";
-				m_player->cInput->left = true;
+				m_localInput.left = true;
 				break;
 			case sf::Keyboard::S: // Down key
 				std::cout << "S Key Pressed\n";
-				m_player->cInput->down = true;
+				m_localInput.down = true;
 				break;
 			case sf::Keyboard::D: // Right key
 				std::cout << "D Key Pressed\n";
-				m_player->cInput->right = true;
+				m_localInput.right = true;
 				break;
 			case sf::Keyboard::P:
 				std::cout << "P Key Pressed\n";
@@ -627,46 +1904,113 @@ void Game::sUserInput()
 		}
 
 		// this event is triggered when a key is released
-		if (event.type == sf::Event::KeyReleased)
+		if (event.type == InputEvent::KeyReleased)
 		{
-			switch (event.key.code)
+			switch (event.key)
 			{
 			case sf::Keyboard::W:
 				std::cout << "W Key Released\n";
-				m_player->cInput->up = false;
+				m_localInput.up = false;
 				break;
 			case sf::Keyboard::A:
 				std::cout << "A Key Released\n";
-				m_player->cInput->left = false;
+				m_localInput.left = false;
 				break;
 			case sf::Keyboard::S:
 				std::cout << "S Key Released\n";
-				m_player->cInput->down = false;
+				m_localInput.down = false;
 				break;
 			case sf::Keyboard::D:
 				std::cout << "D Key Released\n";
-				m_player->cInput->right = false;
+				m_localInput.right = false;
 				break;
 			default:break;
 			}
 		}
 
-		if (event.type == sf::Event::MouseButtonPressed)
+		if (event.type == InputEvent::MousePressed)
 		{
-			if (event.mouseButton.button == sf::Mouse::Left)
+			if (event.button == sf::Mouse::Left)
 			{
-				std::cout << "Left Mouse Button Clicked at (" << event.mouseButton.x << "," << event.mouseButton.y << ")\n";
-				//call spawnBullet here
-				spawnBullet(m_player, Vec2(event.mouseButton.x, event.mouseButton.y));
+				std::cout << "Left Mouse Button Clicked at (" << event.x << "," << event.y << ")\n";
+				// one shot per tick, a second click in the same tick aims it again
+				m_localInput.fire = true;
+				m_localInput.target = screenToWorld(event.x, event.y);
 			}
 
-			if (event.mouseButton.button == sf::Mouse::Right)
+			if (event.button == sf::Mouse::Right)
 			{
-				std::cout << "Right Mouse Button Clicked at (" << event.mouseButton.x << "," << event.mouseButton.y << ")\n";
-				//call spawnSpecialWeapon here
-				spawnSpecialWeapon(m_player);
+				std::cout << "Right Mouse Button Clicked at (" << event.x << "," << event.y << ")\n";
+				m_localInput.special = true;
 			}
+
+			m_inputToSpawn.record(std::chrono::duration_cast<std::chrono::microseconds>(InputClock::now() - event.time).count());
+		}
+	}
+
+	BotAction input = m_localInput;
+	if (m_rollbackConfig.ON)
+	{
+		BotAction& recorded = m_localInputs[m_currentFrame % m_localInputs.size()];
+		if (m_resimulating)
+		{
+			input = recorded;
+		}
+		else
+		{
+			recorded = input;
 		}
 	}
+	m_localInput.fire = false;
+	m_localInput.special = false;
+
+	applyAction(m_player, input);
+}
+
+void Game::sWindowEvents()
+{
+	// keyboard and mouse come from the input thread, only window state is handled here
+	sf::Event event;
+	while (m_window.pollEvent(event))
+	{
+		// this event triggers when the window is closed
+		if (event.type == sf::Event::Closed)
+		{
+			m_running = false;
+		}
 
+		// keep one world unit per pixel and bake the background for the new size
+		if (event.type == sf::Event::Resized)
+		{
+			sf::Vector2f size(static_cast<float>(event.size.width), static_cast<float>(event.size.height));
+			m_hudView = sf::View(sf::FloatRect(0, 0, size.x, size.y));
+			m_camera.setSize(size);
+			m_background.resize(event.size.width, event.size.height);
+
+			// a world that is just the window grows and shrinks with it, and so does everything covering it
+			if (m_worldConfig.W <= 0 || m_worldConfig.H <= 0)
+			{
+				m_worldSize = sf::Vector2u(event.size.width, event.size.height);
+				if (m_regionsConfig.ON)
+				{
+					m_regions.resize(m_regionsConfig.C, m_regionsConfig.R, size.x, size.y);
+				}
+				if (m_chaseConfig.ON)
+				{
+					m_flowField.resize(size.x, size.y, static_cast<float>(m_chaseConfig.CS));
+				}
+			}
+		}
+
+		// stop sampling input while another window has focus
+		if (event.type == sf::Event::LostFocus)
+		{
+			m_input.setFocus(false);
+		}
+
+		if (event.type == sf::Event::GainedFocus)
+		{
+			m_input.setFocus(true);
+		}
+	}
 }
@@ -5,50 +5,237 @@
 
 #include "Entity.h"
 #include "EntityManager.h"
+#include "InputThread.h"
+#include "Histogram.h"
+#include "WaveScheduler.h"
+#include "SpatialIndex.h"
+#include "FlowField.h"
+#include "ParticleSystem.h"
+#include "SystemScheduler.h"
+#include "FrameGovernor.h"
+#include "Background.h"
+#include "MetricsServer.h"
+#include "Benchmark.h"
+#include "EventChannel.h"
+#include "Config.h"
+#include "ConfigWatcher.h"
+#include "Rollback.h"
+#include "WorldRegions.h"
 
-struct PlayerConfig { int SR, CR, FR, FG, FB, OR, OG, OB, OT, V; float S; };
-struct EnemyConfig { int SR, CR, OR, OG, OB, OT, VMIN, VMAX, L, SI; float SMIN, SMAX; };
-struct BulletConfig { int SR, CR, FR, FG, FB, OR, OG, OB, OT, V, L; float S; };
+// Everything a rollback puts back, saved at the start of every tick in rollback mode.
+// Particles, the HUD and metrics are left alone, they only show what happened
+struct GameSnapshot
+{
+	EntitySnapshot entities;
+	WaveScheduler::State waves;
+	std::minstd_rand rng;
+	std::shared_ptr<Entity> player;
+	sf::Vector2f camera;
+	int score = 0;
+	int currentFrame = 0;
+	int lastEnemySpawnTime = 0;
+	int spawnIntervalScale = 1;
+};
 
 class Game
 {
 	sf::RenderWindow m_window; // the window we will draw to
+	sf::Vector2u m_worldSize; // play area, can be bigger than the window
+	WorldConfig m_worldConfig;
+	sf::View m_camera; // follows the player around the world
+	sf::View m_hudView; // window pixels, for the background and the score
+	bool m_headless = false; // no window, input or rendering, for benchmarks
+	Scenario m_scenario; // what a headless run does
 	EntityManager m_entities; // vector of entities to maintain
 	sf::Font m_font; // the font we will use to draw
 	sf::Text m_text; // the score text to be drawn to the screen
 	sf::Texture m_playerTexture;
 	sf::Sprite m_playerSprite;
-	sf::Texture m_backgroundTexture;
-	sf::Sprite m_backgroundSprite;
+	Background m_background; // pre-scaled background image and starfield
+	int m_starLayers = 0; // parallax starfield layers drawn over the background
 	PlayerConfig m_playerConfig;
 	EnemyConfig m_enemyConfig;
 	BulletConfig m_bulletConfig;
+	ChaseConfig m_chaseConfig;
+	Prefab m_bulletPrefab; // built from the config by buildPrefabs, spawning copies these
+	Prefab m_specialPrefab;
+	std::vector<Prefab> m_enemyPrefabs; // by vertex count, see buildPrefabs
+	std::vector<Prefab> m_smallEnemyPrefabs;
 	int m_score = 0;
+	int m_hudScore = 0; // score the text was last built for
+	GameEvents m_events; // what happened this tick, handed to subscribers after the gameplay systems
 	int m_currentFrame = 0;
 	int m_lastEnemySpawnTime = 0;
-	bool m_paused = false; // whether we update game logic
+	bool m_scriptedWaves = false; // run the ring waves on top of the regular spawner
+	std::atomic<bool> m_paused = false; // whether we update game logic, atomic since every system checks it
 	bool m_running = true; // whether the game is running
+	std::minstd_rand m_rng; // every random number the simulation uses, a member instead of rand() so a snapshot can hold it
+
+	InputThread m_input; // samples keyboard / mouse off the main thread
+	Histogram m_inputToSpawn{ "input -> spawn" }; // click to spawnBullet / spawnSpecialWeapon
+	Histogram m_inputToPresent{ "input -> present" }; // any input to the display() that first shows it
+	std::vector<InputClock::time_point> m_presentPending; // inputs applied but not yet displayed
+	BotAction m_localInput; // keys held down by the human player and this tick's clicks, as a bot would do it
 
 	std::shared_ptr<Entity> m_player;
 
+	int m_botCount = 0; // bot players spawned alongside the human one
+	std::string m_botStrategy = "mixed";
+	unsigned m_botSeed = 1;
+
+	ParticleSystem m_particles{ 50000 }; // explosion debris, not entities
+	FlowField m_flowField; // direction toward the player for chasing enemies
+	SpatialIndex m_enemyIndex; // enemies and small enemies, rebuilt every frame after movement
+	WaveScheduler m_waves; // runs the enemy wave scripts, keep below everything the scripts use
+
+	// a bullet and the enemies it touches, [begin, end) of its region's targets
+	struct BulletHits
+	{
+		Entity* bullet;
+		size_t region, begin, end;
+	};
+
+	// an enemy and the player it touches, by index into the player list
+	struct EnemyTouch
+	{
+		size_t player;
+		Entity* enemy;
+	};
+
+	// what one region's entities touch this tick, found in parallel and settled by sRegionCollision
+	struct RegionHits
+	{
+		std::vector<EnemyTouch> players; // every enemy or small enemy touching a player
+		std::vector<BulletHits> bullets;
+		std::vector<Entity*> targets;
+	};
+
+	RegionsConfig m_regionsConfig;
+	std::vector<RegionHits> m_regionHits; // by region
+	std::vector<BulletHits*> m_bulletOrder; // every region's bullets, oldest first
+
+	RollbackConfig m_rollbackConfig;
+	SnapshotRing<GameSnapshot> m_snapshots; // state at the start of each of the last N ticks
+	std::vector<BotAction> m_localInputs; // the human player's input for each of the last N ticks, replayed when resimulating
+	PeerInputs m_peerInputs; // the loopback peer's input, confirmed or predicted
+	LoopbackPeer m_peer;
+	bool m_resimulating = false; // replaying ticks after a rollback, nothing is shown or counted
+	Histogram m_rollbackTime{ "rollback" }; // restore plus resimulation
+	uint64_t m_rollbacks = 0;
+	uint64_t m_resimulatedTicks = 0;
+	uint64_t m_lateInputs = 0; // arrived after their snapshot was gone, played on without correcting
+
+	FrameGovernor m_governor; // trades visual quality for frame time under load
+	bool m_governorOn = true;
+	int m_spawnIntervalScale = 1; // the governor stretches the enemy spawn interval by this
+	std::chrono::steady_clock::time_point m_frameStart;
+
+	Histogram m_tickTime{ "tick" }; // time for one pass over every system
+	int m_metricsPort = 0; // 0 keeps the endpoint off
+	std::vector<std::pair<std::string, std::atomic<int64_t>*>> m_entityGauges; // entity count per tag
+	std::atomic<int64_t>* m_scoreGauge = nullptr;
+	std::atomic<int64_t>* m_frameGauge = nullptr;
+	std::atomic<int64_t>* m_qualityGauge = nullptr;
+	std::atomic<int64_t>* m_particleGauge = nullptr;
+	std::atomic<uint64_t>* m_spawnedCounter = nullptr;
+	std::atomic<uint64_t>* m_destroyedCounter = nullptr;
+	std::atomic<uint64_t>* m_killCounter = nullptr;
+	std::atomic<uint64_t>* m_playerHitCounter = nullptr;
+
+	ThreadPool m_pool; // workers for the system scheduler
+	WorldRegions m_regions{ m_pool }; // owners of everything but the players when the world is sharded
+	SystemScheduler m_systems{ m_pool }; // runs every system each frame, keep below everything the systems use
+	bool m_systemDebug = false; // run systems one by one and report undeclared writes
+
+	MetricsServer m_metrics; // local endpoint for soak tests, keep below everything it reports on
+
+	std::string m_configPath;
+	GameConfig m_config; // as loaded, what a reload is compared against
+	ConfigWatcher m_configWatcher; // reparses config.txt off the game thread when it changes
+
 	void init(const std::string& config); // init the GameState with a config file path
+	void applyConfig(const GameConfig& config); // a reloaded config, between ticks
+	static void holdForRollback(GameConfig& config); // turns off what a rollback can't reproduce
+	void buildPrefabs(); // from the player / enemy / bullet config
+	void buildEnemyPrefab(Prefab& prefab, size_t points, bool small);
+	const Prefab& enemyPrefab(size_t points, bool small) const; // the tables are only resized by buildPrefabs, between ticks
+	void saveSnapshot(GameSnapshot& snapshot);
+	bool restoreSnapshot(GameSnapshot& snapshot); // false if the wave scripts can't be put back, nothing is changed then
+	void rollbackTick(); // rollback mode, before the systems: take in remote input, resimulate if it was mispredicted, save the tick
+	void resolveRemoteInput(); // the first part of rollbackTick
 	void setPaused(bool paused); // pause the game
+	void registerSystems(); // declare every system and what it touches to the scheduler
+	void startMetrics(); // register everything with the metrics endpoint and open it
+	void publishMetrics(); // store this frame's numbers for the metrics endpoint
+	uint64_t fingerprint(AccessMask data); // hash of one kind of data, for the scheduler's debug mode
+	void setQuality(int level); // apply a governor level to everything but the shapes
+	void applyShapeQuality(Entity& entity, int level, bool far); // point count and outline for one shape
 
+	void sFlowField(); // System: Rebuilds the flow field toward the player
 	void sMovement(); // System: Entity position / movement update
-	void sUserInput(); // System: User Input
+	void sUserInput(); // System: User Input, drains the input thread queue
+	void sWindowEvents(); // System: Window events (close, focus)
 	void sLifespan(); // System: Lifespan
 	void sRender(); // System: Render / Drawing
 	void sEnemySpawner(); // System: Spawns Enemies
 	void sCollision(); // System: Collisions
+	void sParticles(); // System: Particle update
+	void sBots(); // System: Bot players decide what to do
+	void sSpatialIndex(); // System: Rebuilds the enemy spatial index
+	void sHoming(); // System: Steers homing projectiles
+	void sCamera(); // System: Camera follows the player
+	void sEvents(); // System: Hands this tick's events to subscribers and updates the HUD
+	void sRegions(); // System: Lifespan and movement, each region of the world on its own thread
+	void sRegionCollision(); // System: Collisions found per region, settled in one place
+
+	// what the systems above do to one entity, shared by the serial and the region versions
+	void movePlayer(Entity& e);
+	void moveEntity(Entity& e);
+	void ageEntity(Entity& e);
+	void keepInWorld(Entity& e); // players against the walls
+	void bounceOffWalls(Entity& e); // enemies against the walls
+	void playerHit(const std::shared_ptr<Entity>& player, Entity& enemy);
+	void bulletHit(Entity& bullet, Entity& target);
 
+	Vec2 screenToWorld(int x, int y) const; // window pixel to world position through the camera
+
+	std::shared_ptr<Entity> addEntity(const std::string& tag); // m_entities.addEntity plus a Spawned event
+	void applyAction(std::shared_ptr<Entity> player, const BotAction& action); // keys into CInput, shots spawned
+
+	// m_entities.spawnBatch plus a Spawned event for each
+	template<typename Init>
+	void spawnBatch(const Prefab& prefab, size_t count, Init&& init)
+	{
+		m_entities.spawnBatch(prefab, count, [&](Entity& e, size_t i)
+		{
+			m_events.spawned.push({ e.id(), prefab.tag });
+			init(e, i);
+		});
+	}
 	void spawnPlayer();
+	void spawnBot(std::shared_ptr<CBot> bot);
 	void spawnEnemy();
-	void spawnSmallEnemies(std::shared_ptr<Entity> entity);
+	void spawnEnemy(const Vec2& pos);
+	void spawnSmallEnemies(const Entity& parent);
 	void spawnBullet(std::shared_ptr<Entity> entity, const Vec2& mousePos);
 	void spawnSpecialWeapon(std::shared_ptr<Entity> entity);
+	void spawnExplosion(const Entity& entity);
+
+	// wave scripts, started in init and driven by sEnemySpawner
+	WaveScript regularWave();
+	WaveScript ringWave();
+	WaveScript firingPattern(); // the scenario's scripted shooting
 
 public:
 
 	Game(const std::string& config); //constructor, take in game config
+	Game(const std::string& config, const Scenario& scenario); // headless, for benchmarks
 	void run();
+	BenchmarkReport runBenchmark(); // runs the scenario's ticks as fast as possible
+
+	// rollback loopback harness
+	bool setPeerDelay(int ticks); // before running, false if it is negative or not shorter than the ticks kept
+	void settle(); // deliver every input still in flight and resimulate, so nothing predicted is left
+	uint64_t stateChecksum(); // positions, velocities, ids and score of everything, equal runs give equal sums
+	void printRollbackStats(std::ostream& out) const;
 };
\ No newline at end of file
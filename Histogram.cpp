@@ -0,0 +1,134 @@
+#include <bit>
+#include <cmath>
+#include <iomanip>
+
+#include "Histogram.h"
+
+Histogram::Histogram(const std::string& name)
+	: m_name(name)
+{
+}
+
+size_t Histogram::bucketFor(uint64_t us)
+{
+	// number of bits needed to store the value, so 1 -> 1, 2..3 -> 2, 4..7 -> 3 ...
+	size_t b = std::bit_width(us);
+	return b < BucketCount ? b : BucketCount - 1;
+}
+
+void Histogram::record(uint64_t us)
+{
+	m_buckets[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+	m_count.fetch_add(1, std::memory_order_relaxed);
+	m_sum.fetch_add(us, std::memory_order_relaxed);
+
+	uint64_t prev = m_max.load(std::memory_order_relaxed);
+	while (us > prev && !m_max.compare_exchange_weak(prev, us, std::memory_order_relaxed))
+	{
+	}
+}
+
+void Histogram::reset()
+{
+	for (auto& b : m_buckets)
+	{
+		b.store(0, std::memory_order_relaxed);
+	}
+	m_count.store(0, std::memory_order_relaxed);
+	m_sum.store(0, std::memory_order_relaxed);
+	m_max.store(0, std::memory_order_relaxed);
+}
+
+const std::string& Histogram::name() const
+{
+	return m_name;
+}
+
+uint64_t Histogram::count() const
+{
+	return m_count.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::max() const
+{
+	return m_max.load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::sum() const
+{
+	return m_sum.load(std::memory_order_relaxed);
+}
+
+double Histogram::mean() const
+{
+	uint64_t n = count();
+	return n ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / n : 0.0;
+}
+
+uint64_t Histogram::bucket(size_t i) const
+{
+	return m_buckets[i].load(std::memory_order_relaxed);
+}
+
+uint64_t Histogram::percentile(double p) const
+{
+	uint64_t n = count();
+	if (n == 0)
+	{
+		return 0;
+	}
+
+	// rank of the sample we are looking for, rounded up so p100 is the last sample
+	uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * n));
+	if (rank == 0)
+	{
+		rank = 1;
+	}
+
+	uint64_t seen = 0;
+	for (size_t i = 0; i < BucketCount; ++i)
+	{
+		seen += bucket(i);
+		if (seen >= rank)
+		{
+			// report the bucket upper bound, but never more than the largest sample
+			uint64_t upper = i == 0 ? 0 : (uint64_t(1) << i) - 1;
+			return upper < max() ? upper : max();
+		}
+	}
+	return max();
+}
+
+void Histogram::print(std::ostream& out) const
+{
+	uint64_t n = count();
+
+	// the mean is printed fixed, put the caller's formatting back afterwards
+	std::ios_base::fmtflags flags = out.flags();
+	std::streamsize precision = out.precision();
+	out << m_name << ": " << n << " samples, mean " << std::fixed << std::setprecision(1) << mean()
+		<< "us, p50 " << percentile(50) << "us, p99 " << percentile(99) << "us, max " << max() << "us\n";
+	out.flags(flags);
+	out.precision(precision);
+
+	if (n == 0)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < BucketCount; ++i)
+	{
+		uint64_t c = bucket(i);
+		if (c == 0)
+		{
+			continue;
+		}
+
+		uint64_t lo = i == 0 ? 0 : uint64_t(1) << (i - 1);
+		uint64_t hi = i == 0 ? 0 : (uint64_t(1) << i) - 1;
+		size_t bar = static_cast<size_t>(40.0 * c / n + 0.5);
+
+		out << "  " << std::setw(8) << lo << " - " << std::setw(8) << hi << "us | "
+			<< std::string(bar, '#') << " " << c << "\n";
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Log2 bucketed histogram of durations in microseconds
+// bucket i holds samples in [2^(i-1), 2^i) us, bucket 0 holds 0us
+// the counters are relaxed atomics so another thread can read them while the game records
+class Histogram
+{
+public:
+	static constexpr size_t BucketCount = 32;
+
+private:
+	std::string m_name;
+	std::array<std::atomic<uint64_t>, BucketCount> m_buckets = {};
+	std::atomic<uint64_t> m_count = 0;
+	std::atomic<uint64_t> m_sum = 0;
+	std::atomic<uint64_t> m_max = 0;
+
+	static size_t bucketFor(uint64_t us);
+
+public:
+	Histogram(const std::string& name);
+
+	void record(uint64_t us);
+	void reset();
+
+	const std::string& name() const;
+	uint64_t count() const;
+	uint64_t max() const;
+	uint64_t sum() const; // of every sample
+	double mean() const;
+	uint64_t bucket(size_t i) const;
+
+	// upper bound of the bucket in which the p-th percentile (0-100) falls
+	uint64_t percentile(double p) const;
+
+	// prints count, mean, p50/p99/max and a small bar per non-empty bucket
+	void print(std::ostream& out) const;
+};
@@ -0,0 +1,122 @@
+#include <iterator>
+
+#include "InputThread.h"
+
+// keys the game reacts to
+static const sf::Keyboard::Key WatchedKeys[] = { sf::Keyboard::W, sf::Keyboard::A, sf::Keyboard::S, sf::Keyboard::D, sf::Keyboard::P };
+static const sf::Mouse::Button WatchedButtons[] = { sf::Mouse::Left, sf::Mouse::Right };
+
+// how often the devices are sampled, 1ms keeps the added latency well under a frame
+static const std::chrono::microseconds SampleInterval{ 1000 };
+
+InputThread::InputThread()
+{
+}
+
+InputThread::~InputThread()
+{
+	stop();
+}
+
+void InputThread::start(const sf::Window& window)
+{
+	if (m_running)
+	{
+		return;
+	}
+
+	m_window = &window;
+	m_running = true;
+	m_thread = std::thread(&InputThread::loop, this);
+}
+
+void InputThread::stop()
+{
+	m_running = false;
+	if (m_thread.joinable())
+	{
+		m_thread.join();
+	}
+}
+
+void InputThread::setFocus(bool focus)
+{
+	m_hasFocus = focus;
+}
+
+bool InputThread::poll(InputEvent& event)
+{
+	return m_queue.pop(event);
+}
+
+uint64_t InputThread::dropped() const
+{
+	return m_dropped.load(std::memory_order_relaxed);
+}
+
+void InputThread::push(const InputEvent& event)
+{
+	if (!m_queue.push(event))
+	{
+		m_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void InputThread::loop()
+{
+	bool keyDown[std::size(WatchedKeys)] = {};
+	bool buttonDown[std::size(WatchedButtons)] = {};
+
+	auto next = InputClock::now();
+
+	while (m_running)
+	{
+		bool focus = m_hasFocus;
+
+		for (size_t i = 0; i < std::size(WatchedKeys); ++i)
+		{
+			// without focus every key counts as released, so nothing stays stuck down
+			bool down = focus && sf::Keyboard::isKeyPressed(WatchedKeys[i]);
+			if (down != keyDown[i])
+			{
+				keyDown[i] = down;
+
+				InputEvent e;
+				e.type = down ? InputEvent::KeyPressed : InputEvent::KeyReleased;
+				e.key = WatchedKeys[i];
+				e.time = InputClock::now();
+				push(e);
+			}
+		}
+
+		for (size_t i = 0; i < std::size(WatchedButtons); ++i)
+		{
+			bool down = focus && sf::Mouse::isButtonPressed(WatchedButtons[i]);
+			if (down && !buttonDown[i])
+			{
+				// window relative cursor position, on Win32 this is GetCursorPos + ScreenToClient
+				// which is safe to call from any thread
+				sf::Vector2i pos = sf::Mouse::getPosition(*m_window);
+
+				InputEvent e;
+				e.type = InputEvent::MousePressed;
+				e.button = WatchedButtons[i];
+				e.x = pos.x;
+				e.y = pos.y;
+				e.time = InputClock::now();
+				push(e);
+			}
+			buttonDown[i] = down;
+		}
+
+		next += SampleInterval;
+		std::this_thread::sleep_until(next);
+
+		// if we fell behind (debugger, suspended process) don't try to catch up
+		auto now = InputClock::now();
+		if (now > next + SampleInterval * 10)
+		{
+			next = now;
+		}
+	}
+}
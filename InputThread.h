@@ -0,0 +1,57 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "SPSCQueue.h"
+
+typedef std::chrono::steady_clock InputClock;
+
+// A single input change captured by the input thread
+struct InputEvent
+{
+	enum Type { KeyPressed, KeyReleased, MousePressed };
+
+	Type type = KeyPressed;
+	sf::Keyboard::Key key = sf::Keyboard::Unknown;
+	sf::Mouse::Button button = sf::Mouse::Left;
+	int x = 0; // mouse position in window pixels
+	int y = 0;
+	InputClock::time_point time; // when the input thread saw the change
+};
+
+// Samples the keyboard and mouse on its own thread and pushes timestamped
+// press / release events into a lock-free queue for the game to drain each tick.
+// Window events (close, focus) still have to be polled on the window's thread,
+// SFML only allows that from the thread that created the window.
+class InputThread
+{
+	static constexpr size_t QueueSize = 256;
+
+	SPSCQueue<InputEvent, QueueSize> m_queue;
+	std::thread m_thread;
+	std::atomic<bool> m_running = false;
+	std::atomic<bool> m_hasFocus = true;
+	std::atomic<uint64_t> m_dropped = 0; // events lost because the queue was full
+	const sf::Window* m_window = nullptr;
+
+	void loop();
+	void push(const InputEvent& event);
+
+public:
+	InputThread();
+	~InputThread();
+
+	void start(const sf::Window& window);
+	void stop();
+
+	// called from the window thread when focus changes, no input is sampled without focus
+	void setFocus(bool focus);
+
+	// consumer side, only the game thread may call this
+	bool poll(InputEvent& event);
+
+	uint64_t dropped() const;
+};
@@ -0,0 +1,292 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#include <psapi.h>
+typedef SOCKET SocketHandle;
+#define closeSocket closesocket
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+typedef int SocketHandle;
+#define closeSocket close
+#endif
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "MetricsServer.h"
+
+// resident memory of this process in bytes, 0 if it can't be found
+static uint64_t residentMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return counters.WorkingSetSize;
+	}
+	return 0;
+#else
+	std::ifstream statm("/proc/self/statm");
+	uint64_t size = 0, resident = 0;
+	if (statm >> size >> resident)
+	{
+		return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+	}
+	return 0;
+#endif
+}
+
+// waits up to ms for something to read on s, false on a timeout or error
+static bool waitReadable(SocketHandle s, int ms)
+{
+	fd_set readable;
+	FD_ZERO(&readable);
+	FD_SET(s, &readable);
+	timeval timeout = { 0, ms * 1000 };
+	return select(static_cast<int>(s) + 1, &readable, nullptr, nullptr, &timeout) > 0;
+}
+
+MetricsServer::MetricsServer()
+{
+}
+
+MetricsServer::~MetricsServer()
+{
+	stop();
+}
+
+std::atomic<int64_t>& MetricsServer::gauge(const std::string& name)
+{
+	m_gauges.emplace_back();
+	m_gauges.back().name = name;
+	return m_gauges.back().value;
+}
+
+std::atomic<uint64_t>& MetricsServer::counter(const std::string& name)
+{
+	m_counters.emplace_back();
+	m_counters.back().name = name;
+	return m_counters.back().value;
+}
+
+void MetricsServer::histogram(const std::string& name, const Histogram& histogram)
+{
+	m_histograms.push_back(HistogramRef{ name, &histogram });
+}
+
+bool MetricsServer::running() const
+{
+	return m_running;
+}
+
+bool MetricsServer::start(unsigned short port)
+{
+	if (m_running)
+	{
+		return true;
+	}
+
+#ifdef _WIN32
+	WSADATA wsa;
+	if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0)
+	{
+		std::cout << "Error!! Failed to start Winsock for metrics.\n";
+		return false;
+	}
+#endif
+
+	SocketHandle s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (s == static_cast<SocketHandle>(-1))
+	{
+		std::cout << "Error!! Failed to create metrics socket.\n";
+		return false;
+	}
+
+	int reuse = 1;
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+	// local only, this is for soak tests on the same machine
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(s, 4) != 0)
+	{
+		std::cout << "Error!! Failed to listen for metrics on port " << port << ".\n";
+		closeSocket(s);
+		return false;
+	}
+
+	m_socket = static_cast<intptr_t>(s);
+	m_running = true;
+	m_thread = std::thread(&MetricsServer::loop, this);
+
+	std::cout << "Metrics at http://127.0.0.1:" << port << "/\n";
+	return true;
+}
+
+void MetricsServer::stop()
+{
+	if (!m_running)
+	{
+		return;
+	}
+
+	m_running = false;
+	m_thread.join();
+	closeSocket(static_cast<SocketHandle>(m_socket));
+	m_socket = -1;
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+void MetricsServer::loop()
+{
+	SocketHandle listener = static_cast<SocketHandle>(m_socket);
+	auto lastRates = std::chrono::steady_clock::now();
+
+	while (m_running)
+	{
+		// wake up at least every 100ms to notice stop() and to keep the rates fresh
+		fd_set readable;
+		FD_ZERO(&readable);
+		FD_SET(listener, &readable);
+		timeval timeout = { 0, 100000 };
+		int ready = select(static_cast<int>(listener) + 1, &readable, nullptr, nullptr, &timeout);
+
+		auto now = std::chrono::steady_clock::now();
+		double elapsed = std::chrono::duration<double>(now - lastRates).count();
+		if (elapsed >= 1.0)
+		{
+			updateRates(elapsed);
+			lastRates = now;
+		}
+
+		if (ready <= 0)
+		{
+			continue;
+		}
+
+		SocketHandle client = accept(listener, nullptr, nullptr);
+		if (client == static_cast<SocketHandle>(-1))
+		{
+			continue;
+		}
+
+		// a client that connects and says nothing is dropped after a second instead of
+		// holding up every other scrape, and straight away once stop() is called
+		bool asked = false;
+		for (int waited = 0; waited < 1000 && m_running && !asked; waited += 100)
+		{
+			asked = waitReadable(client, 100);
+		}
+		if (!asked)
+		{
+			closeSocket(client);
+			continue;
+		}
+
+		// don't let one that stops reading block the send either
+#ifdef _WIN32
+		DWORD sendTimeout = 1000;
+#else
+		timeval sendTimeout = { 1, 0 };
+#endif
+		setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, reinterpret_cast<const char*>(&sendTimeout), sizeof(sendTimeout));
+
+		// the request itself doesn't matter, every path gets the same report
+		char request[1024];
+		recv(client, request, sizeof(request), 0);
+
+		std::string body = report();
+		std::ostringstream response;
+		response << "HTTP/1.0 200 OK\r\n"
+			<< "Content-Type: text/plain; version=0.0.4\r\n"
+			<< "Content-Length: " << body.size() << "\r\n"
+			<< "Connection: close\r\n\r\n"
+			<< body;
+
+		std::string out = response.str();
+		size_t sent = 0;
+		while (sent < out.size())
+		{
+			int n = send(client, out.data() + sent, static_cast<int>(out.size() - sent), 0);
+			if (n <= 0 || !m_running)
+			{
+				break;
+			}
+			sent += n;
+		}
+		closeSocket(client);
+		m_scrapes.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void MetricsServer::updateRates(double seconds)
+{
+	for (auto& c : m_counters)
+	{
+		uint64_t v = c.value.load(std::memory_order_relaxed);
+		c.perSecond = (v - c.lastValue) / seconds;
+		c.lastValue = v;
+	}
+}
+
+std::string MetricsServer::report() const
+{
+	std::ostringstream out;
+
+	for (auto& g : m_gauges)
+	{
+		out << g.name << " " << g.value.load(std::memory_order_relaxed) << "\n";
+	}
+
+	for (auto& c : m_counters)
+	{
+		out << c.name << "_total " << c.value.load(std::memory_order_relaxed) << "\n";
+		out << c.name << "_per_second " << c.perSecond << "\n";
+	}
+
+	for (auto& h : m_histograms)
+	{
+		const Histogram& hist = *h.histogram;
+
+		// a prometheus histogram, every bucket every time so the le labels never change,
+		// the last one has no upper bound so it is the +Inf bucket
+		out << "# TYPE " << h.name << "_us histogram\n";
+		uint64_t cumulative = 0;
+		for (size_t i = 0; i + 1 < Histogram::BucketCount; ++i)
+		{
+			cumulative += hist.bucket(i);
+			uint64_t upper = i == 0 ? 0 : (uint64_t(1) << i) - 1;
+			out << h.name << "_us_bucket{le=\"" << upper << "\"} " << cumulative << "\n";
+		}
+		cumulative += hist.bucket(Histogram::BucketCount - 1);
+		out << h.name << "_us_bucket{le=\"+Inf\"} " << cumulative << "\n";
+		out << h.name << "_us_sum " << hist.sum() << "\n";
+		out << h.name << "_us_count " << cumulative << "\n";
+
+		// the same numbers the game prints, as plain gauges for reading by eye
+		out << "# TYPE " << h.name << "_stats_us gauge\n";
+		out << h.name << "_stats_us{stat=\"mean\"} " << hist.mean() << "\n";
+		out << h.name << "_stats_us{stat=\"p50\"} " << hist.percentile(50) << "\n";
+		out << h.name << "_stats_us{stat=\"p99\"} " << hist.percentile(99) << "\n";
+		out << h.name << "_stats_us{stat=\"max\"} " << hist.max() << "\n";
+	}
+
+	out << "memory_resident_bytes " << residentMemory() << "\n";
+	out << "metrics_scrapes_total " << m_scrapes.load(std::memory_order_relaxed) << "\n";
+	return out.str();
+}
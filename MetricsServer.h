@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Histogram.h"
+
+// Serves the game's live numbers over HTTP on 127.0.0.1, e.g.
+//	curl http://127.0.0.1:9100/
+//
+// The game only ever stores into relaxed atomics (gauges, counters and the
+// Histogram buckets); formatting, rates and the socket all live on the server's
+// own thread, so a scrape never waits on the game loop or the other way round.
+// Register everything before start(), the lists are not locked.
+class MetricsServer
+{
+	struct Gauge
+	{
+		std::string name;
+		std::atomic<int64_t> value = 0;
+	};
+
+	struct Counter
+	{
+		std::string name;
+		std::atomic<uint64_t> value = 0;
+		uint64_t lastValue = 0; // server thread only
+		double perSecond = 0; // server thread only
+	};
+
+	struct HistogramRef
+	{
+		std::string name;
+		const Histogram* histogram;
+	};
+
+	// deques so references handed out stay valid as more are registered
+	std::deque<Gauge> m_gauges;
+	std::deque<Counter> m_counters;
+	std::vector<HistogramRef> m_histograms;
+
+	std::thread m_thread;
+	std::atomic<bool> m_running = false;
+	intptr_t m_socket = -1;
+	std::atomic<uint64_t> m_scrapes = 0;
+
+	void loop();
+	void updateRates(double seconds);
+	std::string report() const;
+
+public:
+	MetricsServer();
+	~MetricsServer();
+	MetricsServer(const MetricsServer&) = delete;
+	MetricsServer& operator = (const MetricsServer&) = delete;
+
+	// a value that goes up and down, e.g. entity counts
+	std::atomic<int64_t>& gauge(const std::string& name);
+
+	// a running total, also reported as a rate per second
+	std::atomic<uint64_t>& counter(const std::string& name);
+
+	// reported as a prometheus histogram in microseconds, plus mean, p50, p99 and max under <name>_stats_us
+	void histogram(const std::string& name, const Histogram& histogram);
+
+	// listen on 127.0.0.1:port, false if the socket can't be opened
+	bool start(unsigned short port);
+	void stop();
+	bool running() const;
+};
@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "ParticleSystem.h"
+
+ParticleSystem::ParticleSystem(size_t capacity)
+	: m_capacity(capacity)
+	, m_limit(capacity)
+	, m_x(capacity), m_y(capacity)
+	, m_vx(capacity), m_vy(capacity)
+	, m_life(capacity), m_invTotal(capacity)
+	, m_r(capacity), m_g(capacity), m_b(capacity)
+{
+	m_vertices.reserve(capacity * 4);
+}
+
+void ParticleSystem::emit(const Vec2& pos, size_t count, float speed, int lifespan, const sf::Color& color)
+{
+	count = std::min(count, m_limit > m_count ? m_limit - m_count : 0);
+	if (count == 0 || lifespan <= 0)
+	{
+		return;
+	}
+
+	std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * std::numbers::pi_v<float>);
+	std::uniform_real_distribution<float> speedDist(0.2f * speed, speed);
+	std::uniform_real_distribution<float> lifeDist(0.5f * lifespan, static_cast<float>(lifespan));
+
+	for (size_t i = m_count; i < m_count + count; ++i)
+	{
+		float angle = angleDist(m_rng);
+		float s = speedDist(m_rng);
+		float life = lifeDist(m_rng);
+
+		m_x[i] = pos.x;
+		m_y[i] = pos.y;
+		m_vx[i] = std::cos(angle) * s;
+		m_vy[i] = std::sin(angle) * s;
+		m_life[i] = life;
+		m_invTotal[i] = 1.0f / life;
+		m_r[i] = color.r;
+		m_g[i] = color.g;
+		m_b[i] = color.b;
+	}
+	m_count += count;
+}
+
+void ParticleSystem::update()
+{
+	const size_t n = m_count;
+	float* x = m_x.data();
+	float* y = m_y.data();
+	float* vx = m_vx.data();
+	float* vy = m_vy.data();
+	float* life = m_life.data();
+	const float drag = m_drag;
+
+	// integrate, no branches so these vectorize
+	for (size_t i = 0; i < n; ++i)
+	{
+		x[i] += vx[i];
+		y[i] += vy[i];
+		vx[i] *= drag;
+		vy[i] *= drag;
+		life[i] -= 1.0f;
+	}
+
+	// drop the dead by compacting in place, every particle is copied
+	// and the write index only moves past the live ones
+	size_t alive = 0;
+	for (size_t i = 0; i < n; ++i)
+	{
+		m_x[alive] = m_x[i];
+		m_y[alive] = m_y[i];
+		m_vx[alive] = m_vx[i];
+		m_vy[alive] = m_vy[i];
+		m_life[alive] = m_life[i];
+		m_invTotal[alive] = m_invTotal[i];
+		m_r[alive] = m_r[i];
+		m_g[alive] = m_g[i];
+		m_b[alive] = m_b[i];
+		alive += m_life[i] > 0.0f;
+	}
+	m_count = alive;
+}
+
+void ParticleSystem::clear()
+{
+	m_count = 0;
+}
+
+void ParticleSystem::setLimit(size_t limit)
+{
+	m_limit = std::min(limit, m_capacity);
+
+	// the oldest particles are at the front, keep the newest ones
+	if (m_count > m_limit)
+	{
+		size_t drop = m_count - m_limit;
+		for (auto* v : { &m_x, &m_y, &m_vx, &m_vy, &m_life, &m_invTotal })
+		{
+			std::copy(v->begin() + drop, v->begin() + m_count, v->begin());
+		}
+		for (auto* v : { &m_r, &m_g, &m_b })
+		{
+			std::copy(v->begin() + drop, v->begin() + m_count, v->begin());
+		}
+		m_count = m_limit;
+	}
+}
+
+size_t ParticleSystem::limit() const
+{
+	return m_limit;
+}
+
+size_t ParticleSystem::capacity() const
+{
+	return m_capacity;
+}
+
+size_t ParticleSystem::count() const
+{
+	return m_count;
+}
+
+void ParticleSystem::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	if (m_count == 0)
+	{
+		return;
+	}
+
+	const float h = m_size * 0.5f;
+	m_vertices.resize(m_count * 4);
+
+	for (size_t i = 0; i < m_count; ++i)
+	{
+		float a = std::clamp(m_life[i] * m_invTotal[i], 0.0f, 1.0f);
+		sf::Color c(m_r[i], m_g[i], m_b[i], static_cast<sf::Uint8>(255 * a));
+
+		sf::Vertex* q = &m_vertices[i * 4];
+		q[0] = sf::Vertex(sf::Vector2f(m_x[i] - h, m_y[i] - h), c);
+		q[1] = sf::Vertex(sf::Vector2f(m_x[i] + h, m_y[i] - h), c);
+		q[2] = sf::Vertex(sf::Vector2f(m_x[i] + h, m_y[i] + h), c);
+		q[3] = sf::Vertex(sf::Vector2f(m_x[i] - h, m_y[i] + h), c);
+	}
+
+	target.draw(m_vertices.data(), m_vertices.size(), sf::Quads, states);
+}
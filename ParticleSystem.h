@@ -0,0 +1,51 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <random>
+#include <vector>
+
+#include "Vec2.h"
+
+// Lightweight particles for debris and explosions, kept out of the EntityManager.
+// Every attribute lives in its own array (structure of arrays) with a fixed
+// capacity, so the update is a handful of straight loops the compiler can
+// vectorize, and the whole system is drawn as one vertex array in one draw call.
+// Particles fade out over their lifespan the same way sLifespan fades entities.
+class ParticleSystem : public sf::Drawable
+{
+	size_t m_capacity = 0;
+	size_t m_limit = 0; // how many may be alive at once, at most m_capacity
+	size_t m_count = 0; // particles [0, m_count) are alive
+
+	std::vector<float> m_x, m_y;
+	std::vector<float> m_vx, m_vy;
+	std::vector<float> m_life; // frames remaining
+	std::vector<float> m_invTotal; // 1 / starting lifespan, for the fade
+	std::vector<sf::Uint8> m_r, m_g, m_b;
+
+	float m_size = 3.0f; // width of a particle in pixels
+	float m_drag = 0.96f; // velocity kept each frame
+
+	std::minstd_rand m_rng; // own generator, particles are only visual and must not touch the game's rand()
+	mutable std::vector<sf::Vertex> m_vertices;
+
+	void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+
+public:
+	ParticleSystem(size_t capacity);
+
+	// burst of count particles flying out in random directions from pos at up to speed,
+	// anything past the limit is dropped
+	void emit(const Vec2& pos, size_t count, float speed, int lifespan, const sf::Color& color);
+
+	// move, slow down and age every particle, then drop the dead ones
+	void update();
+
+	void clear();
+
+	// lower the number of live particles allowed, never above the capacity
+	void setLimit(size_t limit);
+	size_t limit() const;
+	size_t capacity() const;
+	size_t count() const;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "Components.h"
+
+// The components an entity starts with and their starting values, built once from the
+// config (see Game::buildPrefabs) so spawning copies them instead of working every
+// shape, colour and number out again. Anything left empty isn't given to the entity.
+// Whatever differs per entity (position, velocity ...) is set by the spawnBatch initializer.
+struct Prefab
+{
+	std::string tag;
+	std::optional<CTransform> transform;
+	std::optional<CShape> shape;
+	std::optional<CCollision> collision;
+	std::optional<CLifespan> lifespan;
+	std::optional<CScore> score;
+	std::optional<CHoming> homing;
+
+	Prefab() = default;
+	explicit Prefab(const std::string& tag) : tag(tag) {}
+};
@@ -0,0 +1,119 @@
+#include "Rollback.h"
+
+static bool sameInput(const BotAction& a, const BotAction& b)
+{
+	return a.up == b.up && a.down == b.down && a.left == b.left && a.right == b.right
+		&& a.fire == b.fire && a.special == b.special
+		&& (!a.fire || (a.target.x == b.target.x && a.target.y == b.target.y));
+}
+
+void PeerInputs::resize(size_t ticks)
+{
+	m_ticks.assign(ticks, Tick());
+}
+
+PeerInputs::Tick& PeerInputs::slot(int frame)
+{
+	return m_ticks[frame % m_ticks.size()];
+}
+
+const BotAction& PeerInputs::get(int frame)
+{
+	Tick& t = slot(frame);
+	if (t.frame != frame || !t.confirmed)
+	{
+		t.frame = frame;
+		t.confirmed = false;
+
+		// keep moving the same way, but don't guess shots, a wrong shot costs a bullet
+		// on screen that then vanishes
+		t.input = m_last;
+		t.input.fire = false;
+		t.input.special = false;
+	}
+	return t.input;
+}
+
+bool PeerInputs::confirm(int frame, const BotAction& input)
+{
+	Tick& t = slot(frame);
+	bool wrong = t.frame == frame && !t.confirmed && !sameInput(t.input, input);
+
+	t.frame = frame;
+	t.confirmed = true;
+	t.input = input;
+
+	if (frame > m_lastFrame)
+	{
+		m_last = input;
+		m_lastFrame = frame;
+	}
+	return wrong;
+}
+
+void LoopbackPeer::start(unsigned seed, int delay, const Vec2& worldSize)
+{
+	m_rng.seed(seed);
+	m_delay = delay;
+	m_worldSize = worldSize;
+	m_held = BotAction();
+	m_nextTurn = 0;
+	m_inFlight.clear();
+}
+
+void LoopbackPeer::setDelay(int delay)
+{
+	m_delay = delay;
+}
+
+int LoopbackPeer::delay() const
+{
+	return m_delay;
+}
+
+void LoopbackPeer::send(int frame)
+{
+	// holds a direction for a while then picks another, like someone playing
+	if (frame >= m_nextTurn)
+	{
+		std::uniform_int_distribution<int> key(-1, 1);
+		std::uniform_int_distribution<int> hold(20, 60);
+		int x = key(m_rng);
+		int y = key(m_rng);
+		m_held.left = x < 0;
+		m_held.right = x > 0;
+		m_held.up = y < 0;
+		m_held.down = y > 0;
+		m_nextTurn = frame + hold(m_rng);
+	}
+
+	BotAction input = m_held;
+	if (frame % 8 == 0)
+	{
+		std::uniform_real_distribution<float> x(0.0f, m_worldSize.x);
+		std::uniform_real_distribution<float> y(0.0f, m_worldSize.y);
+		input.fire = true;
+		input.target = Vec2(x(m_rng), y(m_rng));
+	}
+	input.special = frame % 300 == 299;
+
+	m_inFlight.push_back({ frame, input });
+}
+
+bool LoopbackPeer::receive(int now, int& frame, BotAction& input)
+{
+	if (m_inFlight.empty() || m_inFlight.front().first + m_delay > now)
+	{
+		return false;
+	}
+
+	frame = m_inFlight.front().first;
+	input = m_inFlight.front().second;
+	m_inFlight.pop_front();
+	return true;
+}
+
+void RemoteStrategy::think(const BotView& view, std::minstd_rand& /*rng*/, Vec2& /*heading*/, BotAction& action) const
+{
+	action = m_inputs.get(view.frame);
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "BotController.h"
+
+// The last N tick states, the slot for tick t is t % N. Slots are reused, so once every
+// slot has been written once taking a snapshot doesn't allocate (as long as the state
+// itself reuses its buffers).
+template<typename T>
+class SnapshotRing
+{
+	struct Slot
+	{
+		int frame = -1;
+		T state;
+	};
+
+	std::vector<Slot> m_slots;
+
+public:
+	void resize(size_t count)
+	{
+		m_slots = std::vector<Slot>(count);
+	}
+
+	size_t size() const
+	{
+		return m_slots.size();
+	}
+
+	// slot to save the state at the start of frame into, overwrites frame - N
+	T& write(int frame)
+	{
+		Slot& slot = m_slots[frame % m_slots.size()];
+		slot.frame = frame;
+		return slot.state;
+	}
+
+	// the state at the start of frame, nullptr if it is too old and has been overwritten
+	T* find(int frame)
+	{
+		if (m_slots.empty() || frame < 0)
+		{
+			return nullptr;
+		}
+
+		Slot& slot = m_slots[frame % m_slots.size()];
+		return slot.frame == frame ? &slot.state : nullptr;
+	}
+};
+
+// The remote player's input for each tick, as far as we know it. A tick whose input
+// hasn't arrived yet is predicted by holding the same keys as the last input that did
+// arrive, without its shots, and what was used is remembered so confirm() can tell
+// when a simulated tick got it wrong.
+class PeerInputs
+{
+	struct Tick
+	{
+		int frame = -1;
+		bool confirmed = false;
+		BotAction input; // confirmed, or the prediction last simulated with
+	};
+
+	std::vector<Tick> m_ticks; // ring by frame
+	BotAction m_last; // newest confirmed input
+	int m_lastFrame = -1;
+
+	Tick& slot(int frame);
+
+public:
+	void resize(size_t ticks); // must cover the input delay plus the rollback window
+
+	// input to simulate frame with, unconfirmed ticks are predicted again every time
+	// so a resimulation uses the newest guess
+	const BotAction& get(int frame);
+
+	// the real input for frame arrived, true if frame was already simulated with something else
+	bool confirm(int frame, const BotAction& input);
+};
+
+// Stands in for a player on another machine, for trying rollback without a network.
+// It plays from its own seed without looking at the game, so what it does never depends
+// on our guesses about it, and each tick's input only reaches us delay ticks after the
+// tick it is for, like it would over a link with that much latency.
+class LoopbackPeer
+{
+	std::minstd_rand m_rng;
+	BotAction m_held; // keys currently down
+	int m_nextTurn = 0; // tick it picks new keys
+	int m_delay = 0;
+	Vec2 m_worldSize;
+	std::deque<std::pair<int, BotAction>> m_inFlight; // frame and input, oldest first
+
+public:
+	void start(unsigned seed, int delay, const Vec2& worldSize);
+	void setDelay(int delay);
+	int delay() const;
+
+	// the peer plays frame, on its side of the link
+	void send(int frame);
+
+	// an input that has arrived by now, oldest first, false once there are none
+	bool receive(int now, int& frame, BotAction& input);
+};
+
+// Bot whose moves come from PeerInputs instead of its own head. The peer's CBot is
+// made with index 0 so view.frame is the tick being simulated.
+class RemoteStrategy : public BotStrategy
+{
+	PeerInputs& m_inputs;
+
+public:
+	RemoteStrategy(PeerInputs& inputs) : m_inputs(inputs) {}
+
+	const char* name() const override { return "remote"; }
+	void think(const BotView& view, std::minstd_rand& rng, Vec2& heading, BotAction& action) const override;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+
+// Single producer / single consumer ring buffer
+// one thread may push and one other thread may pop, no locks are taken
+// Capacity must be a power of two so the indices can be wrapped with a mask
+template <typename T, size_t Capacity>
+class SPSCQueue
+{
+	static_assert((Capacity & (Capacity - 1)) == 0, "SPSCQueue capacity must be a power of two");
+
+	std::array<T, Capacity> m_buffer;
+
+	// head is only written by the consumer, tail only by the producer
+	// keep them on separate cache lines so the two threads don't fight over one line
+	alignas(64) std::atomic<size_t> m_head = 0;
+	alignas(64) std::atomic<size_t> m_tail = 0;
+
+public:
+
+	// producer side, returns false if the queue is full
+	bool push(const T& item)
+	{
+		size_t tail = m_tail.load(std::memory_order_relaxed);
+		if (tail - m_head.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+
+		m_buffer[tail & (Capacity - 1)] = item;
+		m_tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// consumer side, returns false if the queue is empty
+	bool pop(T& item)
+	{
+		size_t head = m_head.load(std::memory_order_relaxed);
+		if (head == m_tail.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+
+		item = m_buffer[head & (Capacity - 1)];
+		m_head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t size() const
+	{
+		return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+	}
+};
@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+#include "SpatialIndex.h"
+
+// keeps a far flung entity from making the grid huge
+static const int MaxCellsPerAxis = 512;
+
+SpatialIndex::SpatialIndex()
+{
+}
+
+void SpatialIndex::clear()
+{
+	m_items.clear();
+	m_cellStart.clear();
+	m_cols = m_rows = 0;
+	m_maxRadius = 0;
+}
+
+void SpatialIndex::add(const EntityVec& entities)
+{
+	for (auto& e : entities)
+	{
+		if (!e->isActive() || !e->cTransform || !e->cCollision)
+		{
+			continue;
+		}
+
+		m_items.push_back(Item{ e.get(), e->cTransform->pos.x, e->cTransform->pos.y, e->cCollision->radius });
+	}
+}
+
+void SpatialIndex::build(float cellSize)
+{
+	m_cellStart.clear();
+	m_cols = m_rows = 0;
+
+	if (m_items.empty())
+	{
+		return;
+	}
+
+	float minX = m_items[0].x, maxX = minX;
+	float minY = m_items[0].y, maxY = minY;
+	m_maxRadius = 0;
+	for (auto& it : m_items)
+	{
+		minX = std::min(minX, it.x); maxX = std::max(maxX, it.x);
+		minY = std::min(minY, it.y); maxY = std::max(maxY, it.y);
+		m_maxRadius = std::max(m_maxRadius, it.radius);
+	}
+
+	// a cell at least as wide as the biggest entity means a circle only ever reaches the neighbouring cells
+	if (cellSize <= 0)
+	{
+		cellSize = std::max(2.0f * m_maxRadius, 1.0f);
+	}
+
+	float width = maxX - minX;
+	float height = maxY - minY;
+	cellSize = std::max({ cellSize, width / MaxCellsPerAxis, height / MaxCellsPerAxis });
+
+	m_cellSize = cellSize;
+	m_minX = minX;
+	m_minY = minY;
+	m_cols = static_cast<int>(width / cellSize) + 1;
+	m_rows = static_cast<int>(height / cellSize) + 1;
+
+	// counting sort of the items by cell
+	size_t cells = static_cast<size_t>(m_cols) * m_rows;
+	m_cellStart.assign(cells + 1, 0);
+
+	std::vector<size_t> cellOf(m_items.size());
+	for (size_t i = 0; i < m_items.size(); ++i)
+	{
+		cellOf[i] = static_cast<size_t>(cellY(m_items[i].y)) * m_cols + cellX(m_items[i].x);
+		m_cellStart[cellOf[i] + 1]++;
+	}
+
+	std::partial_sum(m_cellStart.begin(), m_cellStart.end(), m_cellStart.begin());
+
+	std::vector<size_t> next(m_cellStart.begin(), m_cellStart.end() - 1);
+	std::vector<Item> sorted(m_items.size());
+	for (size_t i = 0; i < m_items.size(); ++i)
+	{
+		sorted[next[cellOf[i]]++] = m_items[i];
+	}
+	m_items.swap(sorted);
+}
+
+size_t SpatialIndex::size() const
+{
+	return m_items.size();
+}
+
+int SpatialIndex::cellX(float x) const
+{
+	return std::clamp(static_cast<int>(std::floor((x - m_minX) / m_cellSize)), 0, m_cols - 1);
+}
+
+int SpatialIndex::cellY(float y) const
+{
+	return std::clamp(static_cast<int>(std::floor((y - m_minY) / m_cellSize)), 0, m_rows - 1);
+}
+
+template <typename F>
+void SpatialIndex::forCells(int x0, int y0, int x1, int y1, F&& f) const
+{
+	x0 = std::max(x0, 0); y0 = std::max(y0, 0);
+	x1 = std::min(x1, m_cols - 1); y1 = std::min(y1, m_rows - 1);
+
+	for (int y = y0; y <= y1; ++y)
+	{
+		// a row of cells is one contiguous run of items
+		size_t begin = m_cellStart[static_cast<size_t>(y) * m_cols + x0];
+		size_t end = m_cellStart[static_cast<size_t>(y) * m_cols + x1 + 1];
+		for (size_t i = begin; i < end; ++i)
+		{
+			f(m_items[i]);
+		}
+	}
+}
+
+void SpatialIndex::radius(const Vec2& center, float r, std::vector<Entity*>& out) const
+{
+	if (m_cols == 0)
+	{
+		return;
+	}
+
+	float reach = r + m_maxRadius;
+	forCells(cellX(center.x - reach), cellY(center.y - reach), cellX(center.x + reach), cellY(center.y + reach),
+		[&](const Item& it)
+		{
+			float dx = it.x - center.x;
+			float dy = it.y - center.y;
+			float rr = r + it.radius;
+			if (dx * dx + dy * dy < rr * rr)
+			{
+				out.push_back(it.entity);
+			}
+		});
+}
+
+void SpatialIndex::nearest(const Vec2& point, size_t k, std::vector<Entity*>& out, float maxDist) const
+{
+	if (m_cols == 0 || k == 0)
+	{
+		return;
+	}
+
+	// max-heap of the best k found so far, the top is the worst of them
+	typedef std::pair<float, Entity*> Candidate;
+	std::priority_queue<Candidate> best;
+	float maxDistSq = maxDist * maxDist;
+
+	int cx = cellX(point.x);
+	int cy = cellY(point.y);
+	int maxRing = std::max({ cx, cy, m_cols - 1 - cx, m_rows - 1 - cy });
+
+	// a point outside the grid is at least this far from every item
+	float outside = std::max({ m_minX - point.x, point.x - (m_minX + m_cols * m_cellSize),
+		m_minY - point.y, point.y - (m_minY + m_rows * m_cellSize), 0.0f });
+
+	for (int ring = 0; ring <= maxRing; ++ring)
+	{
+		// anything in ring r or beyond is at least (r - 1) cells away
+		float ringDist = std::max(outside, (ring - 1) * m_cellSize);
+		if (ring > 0 && ringDist > maxDist)
+		{
+			break;
+		}
+		if (best.size() == k && ringDist > 0 && ringDist * ringDist > best.top().first)
+		{
+			break;
+		}
+
+		auto visit = [&](const Item& it)
+		{
+			float dx = it.x - point.x;
+			float dy = it.y - point.y;
+			float d = dx * dx + dy * dy;
+			if (d > maxDistSq || !it.entity->isActive())
+			{
+				return;
+			}
+			if (best.size() < k)
+			{
+				best.push({ d, it.entity });
+			}
+			else if (d < best.top().first)
+			{
+				best.pop();
+				best.push({ d, it.entity });
+			}
+		};
+
+		if (ring == 0)
+		{
+			forCells(cx, cy, cx, cy, visit);
+			continue;
+		}
+
+		// top and bottom rows of the ring, then the left and right columns between them
+		forCells(cx - ring, cy - ring, cx + ring, cy - ring, visit);
+		forCells(cx - ring, cy + ring, cx + ring, cy + ring, visit);
+		if (cx - ring >= 0)
+		{
+			forCells(cx - ring, cy - ring + 1, cx - ring, cy + ring - 1, visit);
+		}
+		if (cx + ring < m_cols)
+		{
+			forCells(cx + ring, cy - ring + 1, cx + ring, cy + ring - 1, visit);
+		}
+	}
+
+	size_t first = out.size();
+	out.resize(first + best.size());
+	for (size_t i = out.size(); i > first; --i)
+	{
+		out[i - 1] = best.top().second;
+		best.pop();
+	}
+}
+
+Entity* SpatialIndex::nearest(const Vec2& point, float maxDist) const
+{
+	std::vector<Entity*> out;
+	nearest(point, 1, out, maxDist);
+	return out.empty() ? nullptr : out[0];
+}
+
+// walks the grid cells along a normalized ray (Amanatides & Woo), calling visit(cx, cy, t)
+// with the distance t at which the ray enters each cell until visit returns false
+template <typename F>
+static void walkRay(float minX, float minY, float cellSize, int cols, int rows, int pad,
+	float ox, float oy, float dx, float dy, float maxDist, F&& visit)
+{
+	const float inf = std::numeric_limits<float>::infinity();
+
+	// clip the ray to the grid bounds grown by pad cells
+	float lo[2] = { minX - pad * cellSize, minY - pad * cellSize };
+	float hi[2] = { minX + (cols + pad) * cellSize, minY + (rows + pad) * cellSize };
+	float o[2] = { ox, oy };
+	float d[2] = { dx, dy };
+	float tMin = 0, tMax = maxDist;
+
+	for (int a = 0; a < 2; ++a)
+	{
+		if (d[a] == 0)
+		{
+			if (o[a] < lo[a] || o[a] > hi[a])
+			{
+				return;
+			}
+			continue;
+		}
+
+		float t1 = (lo[a] - o[a]) / d[a];
+		float t2 = (hi[a] - o[a]) / d[a];
+		if (t1 > t2)
+		{
+			std::swap(t1, t2);
+		}
+		tMin = std::max(tMin, t1);
+		tMax = std::min(tMax, t2);
+	}
+
+	if (tMin > tMax)
+	{
+		return;
+	}
+
+	float px = ox + dx * tMin;
+	float py = oy + dy * tMin;
+	int cx = std::clamp(static_cast<int>(std::floor((px - minX) / cellSize)), -pad, cols - 1 + pad);
+	int cy = std::clamp(static_cast<int>(std::floor((py - minY) / cellSize)), -pad, rows - 1 + pad);
+
+	int stepX = dx > 0 ? 1 : -1;
+	int stepY = dy > 0 ? 1 : -1;
+	float tMaxX = dx != 0 ? (minX + (cx + (stepX > 0)) * cellSize - ox) / dx : inf;
+	float tMaxY = dy != 0 ? (minY + (cy + (stepY > 0)) * cellSize - oy) / dy : inf;
+	float tDeltaX = dx != 0 ? cellSize / std::abs(dx) : inf;
+	float tDeltaY = dy != 0 ? cellSize / std::abs(dy) : inf;
+
+	float t = tMin;
+	while (t <= tMax)
+	{
+		if (!visit(cx, cy, t))
+		{
+			return;
+		}
+
+		if (tMaxX < tMaxY)
+		{
+			t = tMaxX;
+			tMaxX += tDeltaX;
+			cx += stepX;
+		}
+		else
+		{
+			t = tMaxY;
+			tMaxY += tDeltaY;
+			cy += stepY;
+		}
+
+		if (cx < -pad || cy < -pad || cx > cols - 1 + pad || cy > rows - 1 + pad)
+		{
+			return;
+		}
+	}
+}
+
+// distance along a normalized ray to the first point of the circle, negative on a miss
+static float rayCircle(float ox, float oy, float dx, float dy, float cx, float cy, float r)
+{
+	float mx = ox - cx;
+	float my = oy - cy;
+	float b = mx * dx + my * dy;
+	float c = mx * mx + my * my - r * r;
+
+	// starting inside the circle is a hit at distance 0
+	if (c <= 0)
+	{
+		return 0;
+	}
+	if (b > 0)
+	{
+		return -1;
+	}
+
+	float disc = b * b - c;
+	if (disc < 0)
+	{
+		return -1;
+	}
+	return -b - std::sqrt(disc);
+}
+
+bool SpatialIndex::raycast(const Vec2& origin, const Vec2& direction, float maxDist, RayHit& hit) const
+{
+	float len = std::sqrt(direction.x * direction.x + direction.y * direction.y);
+	if (m_cols == 0 || len == 0)
+	{
+		return false;
+	}
+
+	float dx = direction.x / len;
+	float dy = direction.y / len;
+
+	// a circle can poke into the cells around the one holding its center
+	int pad = static_cast<int>(std::ceil(m_maxRadius / m_cellSize));
+	float slack = (pad + 1) * m_cellSize * 1.5f + m_maxRadius;
+
+	hit = RayHit{};
+	float bestT = maxDist;
+
+	walkRay(m_minX, m_minY, m_cellSize, m_cols, m_rows, pad, origin.x, origin.y, dx, dy, maxDist,
+		[&](int cx, int cy, float t)
+		{
+			// nothing reachable from here on can beat the hit we have
+			if (hit.entity && t - slack > bestT)
+			{
+				return false;
+			}
+
+			forCells(cx - pad, cy - pad, cx + pad, cy + pad, [&](const Item& it)
+			{
+				float ht = rayCircle(origin.x, origin.y, dx, dy, it.x, it.y, it.radius);
+				if (ht >= 0 && ht <= bestT)
+				{
+					bestT = ht;
+					hit.entity = it.entity;
+					hit.distance = ht;
+				}
+			});
+			return true;
+		});
+
+	return hit.entity != nullptr;
+}
+
+void SpatialIndex::segment(const Vec2& a, const Vec2& b, std::vector<RayHit>& out) const
+{
+	float dx = b.x - a.x;
+	float dy = b.y - a.y;
+	float len = std::sqrt(dx * dx + dy * dy);
+	if (m_cols == 0 || len == 0)
+	{
+		return;
+	}
+	dx /= len;
+	dy /= len;
+
+	int pad = static_cast<int>(std::ceil(m_maxRadius / m_cellSize));
+	size_t first = out.size();
+
+	walkRay(m_minX, m_minY, m_cellSize, m_cols, m_rows, pad, a.x, a.y, dx, dy, len,
+		[&](int cx, int cy, float)
+		{
+			forCells(cx - pad, cy - pad, cx + pad, cy + pad, [&](const Item& it)
+			{
+				float ht = rayCircle(a.x, a.y, dx, dy, it.x, it.y, it.radius);
+				if (ht >= 0 && ht <= len)
+				{
+					out.push_back(RayHit{ it.entity, ht });
+				}
+			});
+			return true;
+		});
+
+	// neighbouring cells overlap, so the same entity can be found more than once
+	std::sort(out.begin() + first, out.end(), [](const RayHit& l, const RayHit& r)
+	{
+		return l.entity != r.entity ? l.entity < r.entity : l.distance < r.distance;
+	});
+	out.erase(std::unique(out.begin() + first, out.end(), [](const RayHit& l, const RayHit& r)
+	{
+		return l.entity == r.entity;
+	}), out.end());
+	std::sort(out.begin() + first, out.end(), [](const RayHit& l, const RayHit& r)
+	{
+		return l.distance < r.distance;
+	});
+}
+
+void SpatialIndex::nearest(const std::vector<Vec2>& points, std::vector<Entity*>& out, float maxDist) const
+{
+	out.assign(points.size(), nullptr);
+	if (m_cols == 0)
+	{
+		return;
+	}
+
+	// visit the queries cell by cell so consecutive queries read the same items
+	std::vector<size_t> order(points.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::vector<size_t> key(points.size());
+	for (size_t i = 0; i < points.size(); ++i)
+	{
+		key[i] = static_cast<size_t>(cellY(points[i].y)) * m_cols + cellX(points[i].x);
+	}
+	std::sort(order.begin(), order.end(), [&](size_t l, size_t r) { return key[l] < key[r]; });
+
+	std::vector<Entity*> found;
+	for (size_t i : order)
+	{
+		found.clear();
+		nearest(points[i], 1, found, maxDist);
+		if (!found.empty())
+		{
+			out[i] = found[0];
+		}
+	}
+}
+
+void SpatialIndex::radius(const std::vector<Vec2>& centers, float r, std::vector<std::vector<Entity*>>& out) const
+{
+	out.resize(centers.size());
+	for (auto& v : out)
+	{
+		v.clear();
+	}
+	if (m_cols == 0)
+	{
+		return;
+	}
+
+	std::vector<size_t> order(centers.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::vector<size_t> key(centers.size());
+	for (size_t i = 0; i < centers.size(); ++i)
+	{
+		key[i] = static_cast<size_t>(cellY(centers[i].y)) * m_cols + cellX(centers[i].x);
+	}
+	std::sort(order.begin(), order.end(), [&](size_t l, size_t rr) { return key[l] < key[rr]; });
+
+	for (size_t i : order)
+	{
+		radius(centers[i], r, out[i]);
+	}
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <vector>
+
+#include "EntityManager.h"
+
+// Uniform grid over the entities' CTransform positions and CCollision radii.
+// Rebuilt from scratch once per tick with a counting sort, so building is O(n)
+// and a query only looks at the cells near it instead of every entity.
+//
+// Usage:
+//	index.clear();
+//	index.add(m_entities.getEntities("enemy"));
+//	index.build();
+//	index.nearest(pos, maxDist);
+//
+// Entities are held by raw pointer, the index is only valid until the next
+// EntityManager::update. Queries are const and can run from several threads.
+class SpatialIndex
+{
+public:
+	struct RayHit
+	{
+		Entity* entity = nullptr;
+		float distance = 0; // along the ray to the first point on the entity's collision circle
+	};
+
+private:
+	struct Item
+	{
+		Entity* entity;
+		float x, y, radius;
+	};
+
+	std::vector<Item> m_items; // sorted by cell after build()
+	std::vector<size_t> m_cellStart; // items of cell c are [m_cellStart[c], m_cellStart[c + 1])
+	float m_minX = 0, m_minY = 0;
+	float m_cellSize = 1;
+	float m_maxRadius = 0;
+	int m_cols = 0, m_rows = 0;
+
+	int cellX(float x) const;
+	int cellY(float y) const;
+
+	// calls f(item) for every item in cells [x0, x1] x [y0, y1], clamped to the grid
+	template <typename F>
+	void forCells(int x0, int y0, int x1, int y1, F&& f) const;
+
+public:
+	SpatialIndex();
+
+	void clear();
+
+	// entities without a transform or collision component, or already destroyed, are skipped
+	void add(const EntityVec& entities);
+
+	// sort everything added since clear() into the grid, a cellSize of 0 picks one from the radii
+	void build(float cellSize = 0);
+
+	size_t size() const;
+
+	// every entity whose collision circle overlaps the circle (center, radius)
+	void radius(const Vec2& center, float radius, std::vector<Entity*>& out) const;
+
+	// the k entities with their centers closest to point, nearest first, none further than maxDist
+	// and none destroyed since the build
+	void nearest(const Vec2& point, size_t k, std::vector<Entity*>& out, float maxDist) const;
+	Entity* nearest(const Vec2& point, float maxDist) const;
+
+	// first collision circle hit by the ray, direction does not need to be normalized
+	bool raycast(const Vec2& origin, const Vec2& direction, float maxDist, RayHit& hit) const;
+
+	// every entity whose collision circle touches the segment a -> b, ordered along the segment
+	void segment(const Vec2& a, const Vec2& b, std::vector<RayHit>& out) const;
+
+	// batched versions, out[i] is the answer for points[i]
+	// queries are processed in grid order so neighbouring queries share cached cells
+	void nearest(const std::vector<Vec2>& points, std::vector<Entity*>& out, float maxDist) const;
+	void radius(const std::vector<Vec2>& centers, float radius, std::vector<std::vector<Entity*>>& out) const;
+};
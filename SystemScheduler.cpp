@@ -0,0 +1,260 @@
+#include <chrono>
+#include <iostream>
+
+#include "SystemScheduler.h"
+
+const char* Access::name(uint32_t bit)
+{
+	switch (bit)
+	{
+	case Transform: return "Transform";
+	case Shape: return "Shape";
+	case Collision: return "Collision";
+	case Input: return "Input";
+	case Score: return "Score";
+	case Lifespan: return "Lifespan";
+	case Homing: return "Homing";
+	case Alive: return "Alive";
+	case EntityList: return "EntityList";
+	case Spawn: return "Spawn";
+	case GameState: return "GameState";
+	case Random: return "Random";
+	case Window: return "Window";
+	case InputQueue: return "InputQueue";
+	case Waves: return "Waves";
+	case FlowField: return "FlowField";
+	case SpatialIndex: return "SpatialIndex";
+	case Particles: return "Particles";
+	case Bot: return "Bot";
+	case Camera: return "Camera";
+	case Events: return "Events";
+	default: return "?";
+	}
+}
+
+SystemScheduler::SystemScheduler(ThreadPool& pool)
+	: m_pool(pool)
+{
+}
+
+void SystemScheduler::add(const SystemDesc& system)
+{
+	m_systems.push_back(std::make_unique<System>(system));
+}
+
+void SystemScheduler::setDebug(bool debug, Fingerprint fingerprint)
+{
+	m_debug = debug;
+	m_fingerprint = fingerprint;
+}
+
+size_t SystemScheduler::size() const
+{
+	return m_systems.size();
+}
+
+const std::string& SystemScheduler::name(size_t i) const
+{
+	return m_systems[i]->desc.name;
+}
+
+double SystemScheduler::lastMicros(size_t i) const
+{
+	return m_systems[i]->lastMicros;
+}
+
+const Histogram& SystemScheduler::timeHistogram(size_t i) const
+{
+	return m_systems[i]->time;
+}
+
+bool SystemScheduler::conflicts(const SystemDesc& a, const SystemDesc& b)
+{
+	// two systems on the main thread can't overlap anyway, but keep their order
+	if (a.mainThread && b.mainThread)
+	{
+		return true;
+	}
+
+	return (a.writes & (b.reads | b.writes)) || (b.writes & a.reads);
+}
+
+void SystemScheduler::buildGraph()
+{
+	size_t n = m_systems.size();
+	m_dependents.assign(n, {});
+	m_waitingOn = std::make_unique<std::atomic<int>[]>(n);
+
+	// only the nearest earlier conflicting systems matter for ordering, but the
+	// system count is small so every earlier conflict becomes an edge
+	for (size_t j = 0; j < n; ++j)
+	{
+		int count = 0;
+		for (size_t i = 0; i < j; ++i)
+		{
+			if (conflicts(m_systems[i]->desc, m_systems[j]->desc))
+			{
+				m_dependents[i].push_back(j);
+				++count;
+			}
+		}
+		m_waitingOn[j] = count;
+	}
+}
+
+void SystemScheduler::run()
+{
+	if (m_systems.empty())
+	{
+		return;
+	}
+
+	if (m_debug)
+	{
+		runChecked();
+		return;
+	}
+
+	buildGraph();
+	m_completed = 0;
+	m_mainReady.clear();
+
+	// pick the roots before launching any, a root that finishes early can bring a later
+	// system's count to zero while this loop is still looking and it would run twice
+	std::vector<size_t> roots;
+	for (size_t i = 0; i < m_systems.size(); ++i)
+	{
+		if (m_waitingOn[i] == 0)
+		{
+			roots.push_back(i);
+		}
+	}
+
+	for (size_t i : roots)
+	{
+		launch(i);
+	}
+
+	// run main thread systems as they become ready, and help the pool in between
+	while (true)
+	{
+		size_t next = SIZE_MAX;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			if (m_completed == m_systems.size())
+			{
+				break;
+			}
+			if (!m_mainReady.empty())
+			{
+				next = m_mainReady.back();
+				m_mainReady.pop_back();
+			}
+		}
+
+		if (next != SIZE_MAX)
+		{
+			execute(next);
+			continue;
+		}
+
+		if (!m_pool.runPending())
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_done.wait_for(lock, std::chrono::microseconds(200), [this]()
+			{
+				return m_completed == m_systems.size() || !m_mainReady.empty();
+			});
+		}
+	}
+}
+
+void SystemScheduler::launch(size_t i)
+{
+	if (m_systems[i]->desc.mainThread)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_mainReady.push_back(i);
+		m_done.notify_all();
+		return;
+	}
+
+	m_pool.submit([this, i]() { execute(i); });
+}
+
+void SystemScheduler::execute(size_t i)
+{
+	System& s = *m_systems[i];
+
+	// the condition is checked as late as possible, so a system can switch off
+	// the ones after it in the same tick (pausing, for instance)
+	if (!s.desc.when || s.desc.when())
+	{
+		auto start = std::chrono::steady_clock::now();
+		s.desc.run();
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		s.lastMicros = static_cast<double>(us);
+		s.time.record(us);
+	}
+	else
+	{
+		s.lastMicros = 0;
+	}
+
+	for (size_t d : m_dependents[i])
+	{
+		if (--m_waitingOn[d] == 0)
+		{
+			launch(d);
+		}
+	}
+
+	// notify under the lock, once run() sees the last completion the scheduler may go away
+	std::lock_guard<std::mutex> lock(m_mutex);
+	++m_completed;
+	m_done.notify_all();
+}
+
+void SystemScheduler::runChecked()
+{
+	for (auto& sp : m_systems)
+	{
+		System& s = *sp;
+		if (s.desc.when && !s.desc.when())
+		{
+			s.lastMicros = 0;
+			continue;
+		}
+
+		std::vector<uint64_t> before;
+		if (m_fingerprint)
+		{
+			for (uint32_t bit = 1; bit <= Access::Last; bit <<= 1)
+			{
+				before.push_back(m_fingerprint(bit));
+			}
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		s.desc.run();
+		auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+		s.lastMicros = static_cast<double>(us);
+		s.time.record(us);
+
+		// adding and removing entities changes what every per-entity fingerprint covers,
+		// so for the system that does it only the entity list itself can be checked
+		if (!m_fingerprint || (s.desc.writes & Access::EntityList))
+		{
+			continue;
+		}
+
+		size_t k = 0;
+		for (uint32_t bit = 1; bit <= Access::Last; bit <<= 1, ++k)
+		{
+			if (!(s.desc.writes & bit) && m_fingerprint(bit) != before[k])
+			{
+				std::cout << "System " << s.desc.name << " wrote " << Access::name(bit) << " without declaring it\n";
+			}
+		}
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Histogram.h"
+#include "ThreadPool.h"
+
+// Data a system can read or write, one bit each
+namespace Access
+{
+	enum : uint32_t
+	{
+		None = 0,
+		Transform = 1 << 0,
+		Shape = 1 << 1,
+		Collision = 1 << 2,
+		Input = 1 << 3,
+		Score = 1 << 4,
+		Lifespan = 1 << 5,
+		Homing = 1 << 6,
+		Alive = 1 << 7, // Entity::isActive / destroy
+		EntityList = 1 << 8, // the EntityManager vectors, written by EntityManager::update
+		Spawn = 1 << 9, // EntityManager::addEntity
+		GameState = 1 << 10, // score, score text, counters, paused / running
+		Random = 1 << 11, // Game::m_rng
+		Window = 1 << 12, // the sf::RenderWindow
+		InputQueue = 1 << 13,
+		Waves = 1 << 14,
+		FlowField = 1 << 15,
+		SpatialIndex = 1 << 16,
+		Particles = 1 << 17,
+		Bot = 1 << 18,
+		Camera = 1 << 19,
+		Events = 1 << 20,
+
+		Last = Events
+	};
+
+	const char* name(uint32_t bit);
+}
+
+typedef uint32_t AccessMask;
+
+// Runs a set of systems once per tick. Each system declares what it reads and
+// writes; a system waits for every system registered before it that it
+// conflicts with (one writes what the other reads or writes), everything else
+// runs at the same time on a work stealing pool. Registration order is the
+// order conflicting systems run in, so it matches the old hard coded order.
+//
+// In debug mode the systems run one at a time on the calling thread and a
+// fingerprint of every kind of data is compared before and after each one, any
+// change to data the system did not declare as written is reported. Undeclared
+// reads can't be caught this way.
+class SystemScheduler
+{
+public:
+	struct SystemDesc
+	{
+		std::string name;
+		AccessMask reads = Access::None;
+		AccessMask writes = Access::None;
+		std::function<void()> run;
+		bool mainThread = false; // must run on the thread calling run(), e.g. anything touching the window
+		std::function<bool()> when; // skipped this tick if this returns false
+	};
+
+	typedef std::function<uint64_t(AccessMask bit)> Fingerprint;
+
+private:
+	struct System
+	{
+		SystemDesc desc;
+		Histogram time;
+		double lastMicros = 0;
+
+		System(const SystemDesc& d) : desc(d), time(d.name) {}
+	};
+
+	std::vector<std::unique_ptr<System>> m_systems;
+	ThreadPool& m_pool;
+
+	bool m_debug = false;
+	Fingerprint m_fingerprint;
+
+	// per tick state
+	std::vector<std::vector<size_t>> m_dependents;
+	std::unique_ptr<std::atomic<int>[]> m_waitingOn;
+	std::vector<size_t> m_mainReady;
+	size_t m_completed = 0;
+	std::mutex m_mutex;
+	std::condition_variable m_done;
+
+	static bool conflicts(const SystemDesc& a, const SystemDesc& b);
+
+	void buildGraph();
+	void launch(size_t i);
+	void execute(size_t i);
+	void runChecked();
+
+public:
+	SystemScheduler(ThreadPool& pool);
+
+	void add(const SystemDesc& system);
+
+	// run every system once, returns when all of them are done
+	void run();
+
+	void setDebug(bool debug, Fingerprint fingerprint = nullptr);
+
+	size_t size() const;
+	const std::string& name(size_t i) const;
+	double lastMicros(size_t i) const;
+	const Histogram& timeHistogram(size_t i) const;
+};
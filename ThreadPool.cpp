@@ -0,0 +1,137 @@
+#include "ThreadPool.h"
+
+// index of the pool queue owned by the current thread, -1 on threads outside the pool
+static thread_local int t_queueIndex = -1;
+static thread_local const ThreadPool* t_pool = nullptr;
+
+ThreadPool::ThreadPool(size_t threads)
+{
+	if (threads == 0)
+	{
+		unsigned cores = std::thread::hardware_concurrency();
+		threads = cores > 1 ? cores - 1 : 1;
+	}
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		m_queues.push_back(std::make_unique<Queue>());
+	}
+
+	for (size_t i = 0; i < threads; ++i)
+	{
+		m_threads.emplace_back(&ThreadPool::workerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_quit = true;
+	}
+	m_sleep.notify_all();
+
+	for (auto& t : m_threads)
+	{
+		t.join();
+	}
+}
+
+size_t ThreadPool::size() const
+{
+	return m_threads.size();
+}
+
+void ThreadPool::submit(Task task)
+{
+	// a worker keeps what it spawns, everyone else spreads it around
+	size_t index = (t_pool == this && t_queueIndex >= 0)
+		? static_cast<size_t>(t_queueIndex)
+		: m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+	// counted before it is queued, a worker could otherwise take it and count it
+	// off first, wrapping the counter round
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_pending.fetch_add(1);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+		m_queues[index]->tasks.push_back(std::move(task));
+	}
+	m_sleep.notify_one();
+}
+
+bool ThreadPool::popLocal(size_t index, Task& task)
+{
+	Queue& q = *m_queues[index];
+	std::lock_guard<std::mutex> lock(q.mutex);
+	if (q.tasks.empty())
+	{
+		return false;
+	}
+
+	task = std::move(q.tasks.back());
+	q.tasks.pop_back();
+	return true;
+}
+
+bool ThreadPool::steal(size_t thief, Task& task)
+{
+	for (size_t i = 1; i <= m_queues.size(); ++i)
+	{
+		Queue& q = *m_queues[(thief + i) % m_queues.size()];
+		std::lock_guard<std::mutex> lock(q.mutex);
+		if (!q.tasks.empty())
+		{
+			task = std::move(q.tasks.front());
+			q.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+bool ThreadPool::runPending()
+{
+	if (m_pending.load() == 0)
+	{
+		return false;
+	}
+
+	Task task;
+	size_t start = (t_pool == this && t_queueIndex >= 0) ? static_cast<size_t>(t_queueIndex) : 0;
+	if (!steal(start, task))
+	{
+		return false;
+	}
+
+	m_pending.fetch_sub(1);
+	task();
+	return true;
+}
+
+void ThreadPool::workerLoop(size_t index)
+{
+	t_queueIndex = static_cast<int>(index);
+	t_pool = this;
+
+	while (true)
+	{
+		Task task;
+		if (popLocal(index, task) || steal(index, task))
+		{
+			m_pending.fetch_sub(1);
+			task();
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleep.wait(lock, [this]() { return m_quit || m_pending.load() > 0; });
+		if (m_quit)
+		{
+			return;
+		}
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work stealing thread pool.
+// Every worker has its own task deque, it takes new work from the back of its own
+// deque and steals from the front of the others' when it runs dry, so workers
+// mostly touch their own queue. Tasks submitted from outside the pool are handed
+// out round robin. A thread waiting on results can call runPending() to help out.
+class ThreadPool
+{
+	typedef std::function<void()> Task;
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Task> tasks;
+	};
+
+	std::vector<std::unique_ptr<Queue>> m_queues;
+	std::vector<std::thread> m_threads;
+	std::atomic<size_t> m_pending = 0; // tasks submitted but not started, counted just before they are queued
+	std::atomic<size_t> m_nextQueue = 0;
+	std::atomic<bool> m_quit = false;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleep;
+
+	bool popLocal(size_t index, Task& task);
+	bool steal(size_t thief, Task& task);
+	void workerLoop(size_t index);
+
+public:
+	// threads = 0 picks one less than the number of cores, the caller's thread is the last one
+	explicit ThreadPool(size_t threads = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator = (const ThreadPool&) = delete;
+
+	void submit(Task task);
+
+	// run one queued task on the calling thread, false if there was nothing to run
+	bool runPending();
+
+	size_t size() const;
+};
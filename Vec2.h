@@ -1,29 +1,110 @@
 #pragma once
 
-class Vec2
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include "Fixed16.h"
+
+// 1/sqrt(v) from the bit pattern trick plus two newton steps, good to about 5e-6 relative.
+// Plenty for directions, avoids the sqrt and the divide and vectorizes in plain loops.
+constexpr float fastInvSqrt(float v)
+{
+	float half = v * 0.5f;
+	float y = std::bit_cast<float>(0x5f375a86u - (std::bit_cast<uint32_t>(v) >> 1));
+	y = y * (1.5f - half * y * y);
+	y = y * (1.5f - half * y * y);
+	return y;
+}
+
+// length and normalize for each number type a vector can hold
+template<typename T>
+struct VecMath;
+
+template<>
+struct VecMath<float>
+{
+	static float length(float x, float y)
+	{
+		return std::sqrt(x * x + y * y);
+	}
+
+	static constexpr void normalize(float& x, float& y)
+	{
+		float lengthSquared = x * x + y * y;
+		if (lengthSquared > 0)
+		{
+			float inv = fastInvSqrt(lengthSquared);
+			x *= inv;
+			y *= inv;
+		}
+	}
+};
+
+template<>
+struct VecMath<Fixed16>
+{
+	// squares are summed in 64 bits, in Q16.16 anything past about 181 would overflow
+	static constexpr Fixed16 length(Fixed16 x, Fixed16 y)
+	{
+		uint64_t sum = static_cast<uint64_t>(static_cast<int64_t>(x.raw) * x.raw)
+			+ static_cast<uint64_t>(static_cast<int64_t>(y.raw) * y.raw);
+		return Fixed16::fromRaw(static_cast<int32_t>(Fixed16::isqrt(sum)));
+	}
+
+	// exact divides rather than an approximate reciprocal so every machine agrees
+	static constexpr void normalize(Fixed16& x, Fixed16& y)
+	{
+		Fixed16 len = length(x, y);
+		if (len.raw > 0)
+		{
+			x /= len;
+			y /= len;
+		}
+	}
+};
+
+// Header only so the operators inline straight into the hot loops
+template<typename T = float>
+class Vec2T
 {
 public:
 
-	float x = 0;
-	float y = 0;
+	T x{};
+	T y{};
+
+	constexpr Vec2T() {}
+	constexpr Vec2T(T xin, T yin) : x(xin), y(yin) {}
 
-	Vec2();
-	Vec2(float xin, float yin);
+	constexpr bool operator == (const Vec2T& rhs) const { return x == rhs.x && y == rhs.y; }
+	constexpr bool operator != (const Vec2T& rhs) const { return !(*this == rhs); }
 
-	bool operator == (const Vec2& rhs) const;
-	bool operator != (const Vec2& rhs) const;
+	constexpr Vec2T operator + (const Vec2T& rhs) const { return Vec2T(x + rhs.x, y + rhs.y); }
+	constexpr Vec2T operator - (const Vec2T& rhs) const { return Vec2T(x - rhs.x, y - rhs.y); }
+	constexpr Vec2T operator / (const T val) const { return Vec2T(x / val, y / val); }
+	constexpr Vec2T operator * (const T val) const { return Vec2T(x * val, y * val); }
 
-	Vec2 operator + (const Vec2& rhs) const;
-	Vec2 operator - (const Vec2& rhs) const;
-	Vec2 operator / (const float val) const;
-	Vec2 operator * (const float val) const;
+	constexpr Vec2T& operator += (const Vec2T& rhs) { x += rhs.x; y += rhs.y; return *this; }
+	constexpr Vec2T& operator -= (const Vec2T& rhs) { x -= rhs.x; y -= rhs.y; return *this; }
+	constexpr Vec2T& operator *= (const T val) { x *= val; y *= val; return *this; }
+	constexpr Vec2T& operator /= (const T val) { x /= val; y /= val; return *this; }
 
-	void operator += (const Vec2& rhs);
-	void operator -= (const Vec2& rhs);
-	void operator *= (const float val);
-	void operator /= (const float val);
+	T length() const { return VecMath<T>::length(x, y); }
 
-	float dist(const Vec2& rhs) const;
-	static Vec2 normalize(Vec2 vector);
-	void normalize();
+	// distance between the two points
+	T dist(const Vec2T& rhs) const { return VecMath<T>::length(rhs.x - x, rhs.y - y); }
+
+	// length 1 in the same direction, a zero vector stays zero instead of becoming NaN
+	static constexpr Vec2T normalize(Vec2T vector)
+	{
+		vector.normalize();
+		return vector;
+	}
+
+	constexpr void normalize() { VecMath<T>::normalize(x, y); }
 };
+
+typedef Vec2T<float> Vec2;
+
+// for simulation that has to give the same bits everywhere (lockstep, replays)
+typedef Vec2T<Fixed16> Vec2Fixed;
@@ -0,0 +1,192 @@
+#include <algorithm>
+
+#include "WaveScheduler.h"
+
+WaveScript::WaveScript(Handle handle)
+	: m_handle(handle)
+{
+}
+
+WaveScript::WaveScript(WaveScript&& other) noexcept
+	: m_handle(other.release())
+{
+}
+
+WaveScript& WaveScript::operator = (WaveScript&& other) noexcept
+{
+	if (this != &other)
+	{
+		if (m_handle)
+		{
+			m_handle.destroy();
+		}
+		m_handle = other.release();
+	}
+	return *this;
+}
+
+WaveScript::~WaveScript()
+{
+	// a script that was never started still owns its frame
+	if (m_handle)
+	{
+		m_handle.destroy();
+	}
+}
+
+WaveScript::Handle WaveScript::release()
+{
+	Handle h = m_handle;
+	m_handle = nullptr;
+	return h;
+}
+
+WaveScheduler::WaveScheduler()
+{
+}
+
+WaveScheduler::~WaveScheduler()
+{
+	clear();
+}
+
+void WaveScheduler::start(WaveScript script)
+{
+	WaveScript::Handle handle = script.release();
+	if (!handle)
+	{
+		return;
+	}
+
+	m_scripts.push_back(handle);
+	handle.resume();
+	removeFinished();
+}
+
+void WaveScheduler::update(int currentTick)
+{
+	m_currentTick = currentTick;
+
+	// wake every sleeping script that is due, a script that sleeps again
+	// always sleeps for at least one tick so this loop terminates
+	while (!m_timers.empty() && m_timers.front().wakeTick <= m_currentTick)
+	{
+		std::coroutine_handle<> handle = m_timers.front().handle;
+		std::pop_heap(m_timers.begin(), m_timers.end(), std::greater<Timer>());
+		m_timers.pop_back();
+		handle.resume();
+	}
+
+	// take the list first, scripts resumed here may start waiting again
+	if (!m_conditions.empty())
+	{
+		std::vector<Condition> waiting;
+		waiting.swap(m_conditions);
+
+		for (auto& c : waiting)
+		{
+			if (c.ready())
+			{
+				c.handle.resume();
+			}
+			else
+			{
+				m_conditions.push_back(std::move(c));
+			}
+		}
+	}
+
+	removeFinished();
+}
+
+void WaveScheduler::clear()
+{
+	m_timers.clear();
+	m_conditions.clear();
+
+	for (auto h : m_scripts)
+	{
+		h.destroy();
+	}
+	m_scripts.clear();
+}
+
+void WaveScheduler::save(State& state) const
+{
+	state.currentTick = m_currentTick;
+	state.nextOrder = m_nextOrder;
+	state.timers.assign(m_timers.begin(), m_timers.end());
+	state.scripts.assign(m_scripts.begin(), m_scripts.end());
+	state.waiting.clear();
+	for (auto& c : m_conditions)
+	{
+		state.waiting.push_back(c.handle);
+	}
+}
+
+bool WaveScheduler::restore(const State& state)
+{
+	// a finished script's handle is gone, and one that moved between a delay and a
+	// condition would end up in both lists
+	if (!std::equal(m_scripts.begin(), m_scripts.end(), state.scripts.begin(), state.scripts.end())
+		|| m_conditions.size() != state.waiting.size())
+	{
+		return false;
+	}
+	for (size_t i = 0; i < m_conditions.size(); ++i)
+	{
+		if (m_conditions[i].handle != state.waiting[i])
+		{
+			return false;
+		}
+	}
+
+	m_currentTick = state.currentTick;
+	m_nextOrder = state.nextOrder;
+	m_timers.assign(state.timers.begin(), state.timers.end());
+	return true;
+}
+
+WaveScheduler::DelayAwaiter WaveScheduler::delay(int ticks)
+{
+	return DelayAwaiter{ *this, ticks };
+}
+
+WaveScheduler::ConditionAwaiter WaveScheduler::until(std::function<bool()> ready)
+{
+	return ConditionAwaiter{ *this, std::move(ready) };
+}
+
+int WaveScheduler::currentTick() const
+{
+	return m_currentTick;
+}
+
+size_t WaveScheduler::scriptCount() const
+{
+	return m_scripts.size();
+}
+
+void WaveScheduler::sleep(std::coroutine_handle<> handle, int wakeTick)
+{
+	m_timers.push_back(Timer{ wakeTick, m_nextOrder++, handle });
+	std::push_heap(m_timers.begin(), m_timers.end(), std::greater<Timer>());
+}
+
+void WaveScheduler::wait(std::coroutine_handle<> handle, std::function<bool()> ready)
+{
+	m_conditions.push_back(Condition{ std::move(ready), handle });
+}
+
+void WaveScheduler::removeFinished()
+{
+	std::erase_if(m_scripts, [](auto& h)
+	{
+		if (h.done())
+		{
+			h.destroy();
+			return true;
+		}
+		return false;
+	});
+}
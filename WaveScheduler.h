@@ -0,0 +1,140 @@
+#pragma once
+
+#include <coroutine>
+#include <functional>
+#include <vector>
+
+class WaveScheduler;
+
+// Return type of a wave script coroutine, e.g.
+//
+//	WaveScript Game::myWave()
+//	{
+//		co_await m_waves.delay(60); // wait 60 ticks
+//		spawnEnemy();
+//		co_await m_waves.until([this]() { return m_entities.getEntities("enemy").empty(); });
+//		...
+//	}
+//
+// The script does not run until it is handed to WaveScheduler::start
+class WaveScript
+{
+public:
+	struct promise_type
+	{
+		WaveScript get_return_object() { return WaveScript(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; } // the scheduler destroys finished scripts
+		void return_void() {}
+		void unhandled_exception() { throw; }
+	};
+
+	typedef std::coroutine_handle<promise_type> Handle;
+
+	WaveScript(WaveScript&& other) noexcept;
+	WaveScript& operator = (WaveScript&& other) noexcept;
+	WaveScript(const WaveScript&) = delete;
+	WaveScript& operator = (const WaveScript&) = delete;
+	~WaveScript();
+
+private:
+	friend class WaveScheduler;
+
+	Handle m_handle;
+
+	explicit WaveScript(Handle handle);
+	Handle release();
+};
+
+// Runs wave scripts. A script suspended on delay() sits in a min-heap keyed by
+// wake tick and costs nothing until that tick comes up, so any number of timed
+// scripts can be waiting at once. Scripts suspended on until() have their
+// condition checked once per update.
+class WaveScheduler
+{
+	struct Timer
+	{
+		int wakeTick = 0;
+		size_t order = 0; // keeps scripts waking on the same tick in the order they slept
+		std::coroutine_handle<> handle;
+
+		bool operator > (const Timer& rhs) const
+		{
+			return wakeTick != rhs.wakeTick ? wakeTick > rhs.wakeTick : order > rhs.order;
+		}
+	};
+
+	struct Condition
+	{
+		std::function<bool()> ready;
+		std::coroutine_handle<> handle;
+	};
+
+	std::vector<Timer> m_timers; // min-heap on wake tick
+	std::vector<Condition> m_conditions;
+	std::vector<WaveScript::Handle> m_scripts; // every script still alive, owned here
+	int m_currentTick = 0;
+	size_t m_nextOrder = 0;
+
+	void sleep(std::coroutine_handle<> handle, int wakeTick);
+	void wait(std::coroutine_handle<> handle, std::function<bool()> ready);
+	void removeFinished();
+
+public:
+
+	// Timing state for rollback. Only which scripts sleep until when is kept, a coroutine's
+	// locals and the co_await it is stopped at are opaque, so restoring is exact only for
+	// scripts that always wait at the same delay() in a loop and keep no other state
+	// between iterations (work it out from currentTick() instead).
+	struct State
+	{
+		int currentTick = 0;
+		size_t nextOrder = 0;
+		std::vector<Timer> timers;
+		std::vector<std::coroutine_handle<>> scripts; // what was alive and what was waiting on a condition,
+		std::vector<std::coroutine_handle<>> waiting; // restore refuses if either has changed since
+	};
+
+	struct DelayAwaiter
+	{
+		WaveScheduler& scheduler;
+		int ticks;
+
+		bool await_ready() const noexcept { return ticks <= 0; }
+		void await_suspend(std::coroutine_handle<> h) { scheduler.sleep(h, scheduler.m_currentTick + ticks); }
+		void await_resume() const noexcept {}
+	};
+
+	struct ConditionAwaiter
+	{
+		WaveScheduler& scheduler;
+		std::function<bool()> ready;
+
+		bool await_ready() const { return ready(); }
+		void await_suspend(std::coroutine_handle<> h) { scheduler.wait(h, std::move(ready)); }
+		void await_resume() const noexcept {}
+	};
+
+	WaveScheduler();
+	~WaveScheduler();
+	WaveScheduler(const WaveScheduler&) = delete;
+	WaveScheduler& operator = (const WaveScheduler&) = delete;
+
+	// start running a script, it runs up to its first co_await straight away
+	void start(WaveScript script);
+
+	// resume every script whose delay ran out or whose condition is now true
+	void update(int currentTick);
+
+	// destroy every script
+	void clear();
+
+	void save(State& state) const;
+	bool restore(const State& state); // false, and nothing changed, if a script started, ended or moved between delay() and until()
+
+	DelayAwaiter delay(int ticks);
+	ConditionAwaiter until(std::function<bool()> ready);
+
+	int currentTick() const;
+	size_t scriptCount() const;
+};
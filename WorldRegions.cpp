@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "WorldRegions.h"
+
+WorldRegions::WorldRegions(ThreadPool& pool)
+	: m_pool(pool)
+{
+}
+
+void WorldRegions::resize(int cols, int rows, float width, float height)
+{
+	m_cols = cols > 0 ? cols : static_cast<int>(m_pool.size()) + 1;
+	m_rows = std::max(rows, 1);
+	m_cellWidth = std::max(width / m_cols, 1.0f);
+	m_cellHeight = std::max(height / m_rows, 1.0f);
+
+	m_regions = std::vector<Region>(m_cols * m_rows);
+	for (auto& r : m_regions)
+	{
+		r.outbox.resize(m_regions.size());
+	}
+	reset();
+}
+
+void WorldRegions::reset()
+{
+	m_placeAll = true;
+}
+
+void WorldRegions::sync(const EntityVec& entities, const Owned& owned)
+{
+	if (m_placeAll)
+	{
+		for (auto& r : m_regions)
+		{
+			r.entities.clear();
+			for (auto& out : r.outbox)
+			{
+				out.clear();
+			}
+		}
+		m_nextId = 0;
+		m_placeAll = false;
+	}
+	else
+	{
+		forEach([](size_t, Region& r)
+		{
+			std::erase_if(r.entities, [](auto& e) { return !e->isActive(); });
+		});
+	}
+
+	// new entities are at the end of the list, they are the only ones with ids this high
+	size_t first = entities.size();
+	while (first > 0 && entities[first - 1]->id() >= m_nextId)
+	{
+		--first;
+	}
+
+	for (size_t i = first; i < entities.size(); ++i)
+	{
+		const auto& e = entities[i];
+		if (owned(*e))
+		{
+			m_regions[regionOf(e->cTransform->pos)].entities.push_back(e);
+		}
+	}
+
+	if (!entities.empty())
+	{
+		m_nextId = std::max(m_nextId, entities.back()->id() + 1);
+	}
+}
+
+void WorldRegions::forEach(const std::function<void(size_t, Region&)>& work)
+{
+	std::atomic<size_t> remaining = m_regions.size() - 1;
+	for (size_t i = 1; i < m_regions.size(); ++i)
+	{
+		m_pool.submit([&, i]()
+		{
+			work(i, m_regions[i]);
+			remaining--;
+		});
+	}
+
+	// the calling thread takes the first region and then helps with the rest
+	work(0, m_regions[0]);
+	while (remaining > 0)
+	{
+		if (!m_pool.runPending())
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+size_t WorldRegions::regionOf(const Vec2& pos) const
+{
+	int x = std::clamp(static_cast<int>(pos.x / m_cellWidth), 0, m_cols - 1);
+	int y = std::clamp(static_cast<int>(pos.y / m_cellHeight), 0, m_rows - 1);
+	return static_cast<size_t>(y * m_cols + x);
+}
+
+void WorldRegions::handOff()
+{
+	for (auto& from : m_regions)
+	{
+		for (auto& out : from.outbox)
+		{
+			m_handoffs += out.size();
+		}
+	}
+
+	// each region drains the outboxes addressed to it, in region order
+	forEach([this](size_t to, Region& region)
+	{
+		for (auto& from : m_regions)
+		{
+			EntityVec& arrived = from.outbox[to];
+			region.entities.insert(region.entities.end(), arrived.begin(), arrived.end());
+			arrived.clear();
+		}
+	});
+}
+
+size_t WorldRegions::size() const
+{
+	return m_regions.size();
+}
+
+size_t WorldRegions::handoffs() const
+{
+	return m_handoffs;
+}
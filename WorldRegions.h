@@ -0,0 +1,91 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include "EntityManager.h"
+#include "ThreadPool.h"
+
+// The world cut into a grid of regions, each owning the entities inside it. Only the task
+// running a region touches its entities, so every region can be simulated at the same time
+// without locks. An entity that moves out of its region is left in that region's outbox
+// for the one it moved into, and picked up by it in handOff(). Outboxes are drained in
+// region order, so who owns what never depends on which task finished first.
+//
+// Usage, once per tick after EntityManager::update:
+//	regions.sync(m_entities.getEntities(), owned);
+//	regions.update([](Entity& e) { ... move e ... });
+//	regions.forEach([](size_t i, WorldRegions::Region& r) { ... read or change r.entities ... });
+//
+// Entities outside the world belong to the nearest region on the border.
+class WorldRegions
+{
+public:
+	struct Region
+	{
+		EntityVec entities;
+		std::vector<EntityVec> outbox; // by the region the entity moved into
+	};
+
+	typedef std::function<bool(const Entity&)> Owned;
+
+private:
+	ThreadPool& m_pool;
+	std::vector<Region> m_regions;
+	int m_cols = 1, m_rows = 1;
+	float m_cellWidth = 1, m_cellHeight = 1;
+	size_t m_nextId = 0; // entities from this id on haven't been placed yet
+	bool m_placeAll = true;
+	size_t m_handoffs = 0;
+
+public:
+	WorldRegions(ThreadPool& pool);
+
+	// cols = 0 picks one column per thread, the pool's workers plus the caller
+	void resize(int cols, int rows, float width, float height);
+
+	// forget who owns what, everything is placed again by the next sync (after a rollback)
+	void reset();
+
+	// drop destroyed entities and place the ones created since the last sync, entities
+	// have to be in id order (EntityManager keeps them that way)
+	void sync(const EntityVec& entities, const Owned& owned);
+
+	// work(index, region) for every region at once on the pool, returns when all are done
+	void forEach(const std::function<void(size_t, Region&)>& work);
+
+	// the region a position is in
+	size_t regionOf(const Vec2& pos) const;
+
+	// update(entity) for every owned entity, region by region on the pool, then hands off
+	// the ones that ended up in another region
+	template<typename F>
+	void update(F&& update)
+	{
+		forEach([&](size_t i, Region& r)
+		{
+			size_t kept = 0;
+			for (auto& e : r.entities)
+			{
+				update(*e);
+				size_t to = regionOf(e->cTransform->pos);
+				if (to == i)
+				{
+					r.entities[kept++] = std::move(e);
+				}
+				else
+				{
+					r.outbox[to].push_back(std::move(e));
+				}
+			}
+			r.entities.erase(r.entities.begin() + kept, r.entities.end());
+		});
+		handOff();
+	}
+
+	// moves everything left in an outbox to the region it is for
+	void handOff();
+
+	size_t size() const;
+	size_t handoffs() const; // entities that changed region, since the start
+};
@@ -1,11 +1,177 @@
+#include <filesystem>
 #include <iostream>
+#include <string>
 #include <SFML/Graphics.hpp>
 #include "Game.h"
 #include "Vec2.h"
 
+// game --bench <scenario> [--out <report.json>] [--baseline <report.json>] [--threshold <percent>]
+// runs the scenario headless and writes a JSON report, exits with 1 if it regressed against the baseline
+static int bench(int argc, char* argv[])
+{
+    std::string scenarioPath = argc > 2 ? argv[2] : "";
+    std::string outPath = "bench_report.json";
+    std::string baselinePath;
+    double threshold = 10.0;
+
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--out") outPath = argv[i + 1];
+        else if (arg == "--baseline") baselinePath = argv[i + 1];
+        else if (arg == "--threshold") threshold = std::stod(argv[i + 1]);
+        else
+        {
+            std::cout << "Unknown option " << arg << "\n";
+            return 2;
+        }
+    }
+
+    Scenario scenario;
+    if (!scenario.load(scenarioPath))
+    {
+        std::cout << "Error!! Failed to load scenario " << scenarioPath << ".\n";
+        return 2;
+    }
+
+    BenchmarkReport report;
+    {
+        Game g("config.txt", scenario);
+        report = g.runBenchmark();
+    }
+    report.print(std::cout);
 
-int main()
+    if (!report.save(outPath))
+    {
+        std::cout << "Error!! Failed to write " << outPath << ".\n";
+        return 2;
+    }
+
+    if (!baselinePath.empty())
+    {
+        BenchmarkReport baseline;
+        if (!baseline.load(baselinePath))
+        {
+            std::cout << "Error!! Failed to read baseline " << baselinePath << ".\n";
+            return 2;
+        }
+        return compareReports(baseline, report, threshold, std::cout) ? 0 : 1;
+    }
+
+    return 0;
+}
+
+// game --loopback <scenario> [--delay <ticks>]
+// plays the scenario headless against the loopback peer twice, first with the peer's input arriving
+// straight away and then late, and checks both runs end in the same state, exits with 1 if not.
+// The scenario turns rollback on itself (Rollback 1 <ticks kept> <delay>), --delay overrides its delay
+static int loopback(int argc, char* argv[])
 {
+    std::string scenarioPath = argc > 2 ? argv[2] : "";
+    int delay = -1; // the scenario's own
+
+    for (int i = 3; i + 1 < argc; i += 2)
+    {
+        std::string arg = argv[i];
+        if (arg == "--delay") delay = std::stoi(argv[i + 1]);
+        else
+        {
+            std::cout << "Unknown option " << arg << "\n";
+            return 2;
+        }
+    }
+
+    Scenario scenario;
+    if (!scenario.load(scenarioPath))
+    {
+        std::cout << "Error!! Failed to load scenario " << scenarioPath << ".\n";
+        return 2;
+    }
+
+    bool delayFits = true;
+    auto play = [&](const char* label, int peerDelay) -> uint64_t
+    {
+        Game g("config.txt", scenario);
+
+        // checked on both runs, so a --delay that doesn't fit stops before anything plays
+        if (delay != -1 && !g.setPeerDelay(delay))
+        {
+            delayFits = false;
+            return 0;
+        }
+        if (peerDelay >= 0)
+        {
+            g.setPeerDelay(peerDelay);
+        }
+        BenchmarkReport report = g.runBenchmark();
+        g.settle();
+
+        std::cout << label << "\n";
+        report.print(std::cout);
+        g.printRollbackStats(std::cout);
+        return g.stateChecksum();
+    };
+
+    uint64_t reference = play("Peer input on time", 0);
+    if (!delayFits)
+    {
+        std::cout << "Error!! --delay has to be 0 or more and less than the ticks kept (Rollback N).\n";
+        return 2;
+    }
+    uint64_t delayed = play("Peer input delayed", delay);
+
+    std::cout << std::hex << "State checksum " << reference << " on time, " << delayed << " delayed" << std::dec << "\n";
+    if (reference != delayed)
+    {
+        std::cout << "MISMATCH, the rollback did not reproduce the on time run\n";
+        return 1;
+    }
+    return 0;
+}
+
+// game --compile-config [config.txt]
+// checks the config and writes config.bin next to it, which startup reads instead of the text until the text changes
+static int compileConfig(int argc, char* argv[])
+{
+    std::string path = argc > 2 ? argv[2] : "config.txt";
+    std::string compiled = std::filesystem::path(path).replace_extension(".bin").string();
+
+    GameConfig config;
+    std::vector<std::string> errors;
+    if (!loadConfig(path, config, errors))
+    {
+        for (auto& e : errors)
+        {
+            std::cout << e << "\n";
+        }
+        return 1;
+    }
+
+    if (!saveCompiledConfig(compiled, config, path))
+    {
+        std::cout << "Error!! Failed to write " << compiled << ".\n";
+        return 2;
+    }
+
+    std::cout << "Wrote " << compiled << "\n";
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && std::string(argv[1]) == "--bench")
+    {
+        return bench(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--loopback")
+    {
+        return loopback(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "--compile-config")
+    {
+        return compileConfig(argc, argv);
+    }
+
     Game g("config.txt");
     g.run();
 }